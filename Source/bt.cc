@@ -5,13 +5,82 @@
 #include "bt.h"
 
 #include <algorithm> // for max
+#include <bit>		 // for bit_width
 #include <cstdio>	 // for printf
+#include <limits>	 // for numeric_limits
+#include <mutex>	 // for mutex
 #include <random>	 // for mt19937
 #include <thread>	 // for this_thread::sleep_for
 
+#if defined(__linux__)
+#include <sys/mman.h> // for mmap, madvise, mlock
+#endif
+
 namespace bt
 {
 
+	/////////////////
+	/// Blackboard
+	/////////////////
+
+	std::pair<std::size_t, std::size_t> BlackboardLayout::AddSlot(std::string_view name, const std::type_info& type,
+		std::size_t size, std::size_t align, void (*construct)(void*), void (*destroy)(void*))
+	{
+		for (std::size_t i = 0; i < slots.size(); i++)
+		{
+			if (slots[i].name != name)
+				continue;
+			if (*slots[i].type != type)
+			{
+				std::string s = "bt: blackboard key type mismatch ";
+				s += name;
+				throw std::runtime_error(s);
+			}
+			return { i, slots[i].offset };
+		}
+		if (sealed)
+			throw std::runtime_error("bt: blackboard layout sealed");
+		auto offset = (this->size + align - 1) / align * align;
+		slots.push_back({ std::string(name), &type, offset, construct, destroy });
+		this->size = offset + size;
+		this->align = std::max(this->align, align);
+		return { slots.size() - 1, offset };
+	}
+
+	Blackboard::Blackboard(BlackboardLayout& layout)
+		: layout(&layout)
+	{
+		layout.sealed = true;
+		versions.resize(layout.slots.size(), 0);
+		data = static_cast<unsigned char*>(
+			::operator new(std::max<std::size_t>(layout.size, 1), std::align_val_t(layout.align)));
+		std::size_t i = 0;
+		try
+		{
+			for (; i < layout.slots.size(); i++)
+				layout.slots[i].construct(data + layout.slots[i].offset);
+		}
+		catch (...)
+		{
+			// Rolls back the constructed ones.
+			while (i-- > 0)
+				if (layout.slots[i].destroy != nullptr)
+					layout.slots[i].destroy(data + layout.slots[i].offset);
+			::operator delete(data, std::align_val_t(layout.align));
+			throw;
+		}
+	}
+
+	Blackboard::~Blackboard()
+	{
+		if (data == nullptr)
+			return;
+		for (auto& slot : layout->slots)
+			if (slot.destroy != nullptr)
+				slot.destroy(data + slot.offset);
+		::operator delete(data, std::align_val_t(layout->align));
+	}
+
 	/////////////////
 	/// TreeBlob
 	/////////////////
@@ -26,44 +95,828 @@ namespace bt
 		return { Allocate(idx, size), true };
 	}
 
+	NodeBlob* ITreeBlob::Peek(const NodeId id)
+	{
+		std::size_t idx = id - 1;
+		return Exist(idx) ? static_cast<NodeBlob*>(Get(idx)) : nullptr;
+	}
+
+	// Granularity of BlobPool's size classes, also the alignment of the blocks.
+	static constexpr std::size_t BlobPoolAlign = 16;
+	static constexpr std::size_t NumBlobPoolClasses = BlobPool::MaxSize / BlobPoolAlign;
+	// Number of blocks to move between a thread cache and the shared free lists at once.
+	static constexpr std::size_t BlobPoolBatch = 32;
+	static constexpr std::size_t BlobPoolSlabSize = 64 * 1024;
+
+	// Free blocks are linked via their first bytes.
+	struct BlobPoolFreeList
+	{
+		void*		head = nullptr;
+		std::size_t n = 0;
+
+		void Push(void* p)
+		{
+			*static_cast<void**>(p) = head;
+			head = p;
+			++n;
+		}
+
+		void* Pop()
+		{
+			auto p = head;
+			head = *static_cast<void**>(p);
+			--n;
+			return p;
+		}
+
+		// Moves at most k blocks to given list.
+		void MoveTo(BlobPoolFreeList& to, std::size_t k)
+		{
+			while (k-- > 0 && head != nullptr)
+				to.Push(Pop());
+		}
+	};
+
+	// Shared free lists of all size classes.
+	struct BlobPoolCentral
+	{
+		std::mutex				 mu[NumBlobPoolClasses];
+		BlobPoolFreeList		 lists[NumBlobPoolClasses];
+		std::atomic<std::size_t> reserved = 0;
+
+		// Moves a batch of blocks of class c to given list, carves a new slab if there's none.
+		void Refill(std::size_t c, BlobPoolFreeList& to)
+		{
+			std::lock_guard lock(mu[c]);
+			if (lists[c].head == nullptr)
+			{
+				auto size = (c + 1) * BlobPoolAlign;
+				auto slab = static_cast<unsigned char*>(::operator new(BlobPoolSlabSize));
+				reserved.fetch_add(BlobPoolSlabSize, std::memory_order_relaxed);
+				for (std::size_t off = 0; off + size <= BlobPoolSlabSize; off += size)
+					lists[c].Push(slab + off);
+			}
+			lists[c].MoveTo(to, BlobPoolBatch);
+		}
+
+		void Put(std::size_t c, BlobPoolFreeList& from, std::size_t k)
+		{
+			std::lock_guard lock(mu[c]);
+			from.MoveTo(lists[c], k);
+		}
+	};
+
+	static BlobPoolCentral& GetBlobPoolCentral()
+	{
+		// Leaked on purpose, it must outlive the thread caches.
+		static auto c = new BlobPoolCentral;
+		return *c;
+	}
+
+	// Is current thread's cache destroyed? It's trivially destructible, so it's still valid after thread exit.
+	static thread_local bool blobPoolCacheDestroyed = false;
+
+	struct BlobPoolCache
+	{
+		BlobPoolFreeList lists[NumBlobPoolClasses];
+
+		~BlobPoolCache()
+		{
+			auto& central = GetBlobPoolCentral();
+			for (std::size_t c = 0; c < NumBlobPoolClasses; c++)
+				central.Put(c, lists[c], lists[c].n);
+			blobPoolCacheDestroyed = true;
+		}
+	};
+
+	static thread_local BlobPoolCache blobPoolCache;
+
+	void* BlobPool::Allocate(std::size_t size)
+	{
+		if (size > MaxSize)
+			return ::operator new(size);
+		auto c = size > 0 ? (size - 1) / BlobPoolAlign : 0;
+		if (blobPoolCacheDestroyed)
+		{
+			BlobPoolFreeList l;
+			GetBlobPoolCentral().Refill(c, l);
+			auto p = l.Pop();
+			GetBlobPoolCentral().Put(c, l, l.n);
+			return p;
+		}
+		auto& l = blobPoolCache.lists[c];
+		if (l.head == nullptr)
+			GetBlobPoolCentral().Refill(c, l);
+		return l.Pop();
+	}
+
+	void BlobPool::Deallocate(void* p, std::size_t size)
+	{
+		if (size > MaxSize)
+			return ::operator delete(p);
+		auto c = size > 0 ? (size - 1) / BlobPoolAlign : 0;
+		if (blobPoolCacheDestroyed)
+		{
+			BlobPoolFreeList l;
+			l.Push(p);
+			return GetBlobPoolCentral().Put(c, l, 1);
+		}
+		auto& l = blobPoolCache.lists[c];
+		l.Push(p);
+		// Keeps at most 2 batches in the thread cache.
+		if (l.n >= 2 * BlobPoolBatch)
+			GetBlobPoolCentral().Put(c, l, BlobPoolBatch);
+	}
+
+	std::size_t BlobPool::NumReservedBytes()
+	{
+		return GetBlobPoolCentral().reserved.load(std::memory_order_relaxed);
+	}
+
+	DynamicTreeBlob::DynamicTreeBlob(DynamicTreeBlob&& o) noexcept
+		: pooled(o.pooled), m(std::move(o.m))
+	{
+		o.m.clear();
+	}
+
+	DynamicTreeBlob& DynamicTreeBlob::operator=(DynamicTreeBlob&& o) noexcept
+	{
+		if (this != &o)
+		{
+			Release();
+			pooled = o.pooled;
+			m = std::move(o.m);
+			o.m.clear();
+		}
+		return *this;
+	}
+
+	void DynamicTreeBlob::Destroy(Slot& slot)
+	{
+		if (slot.exist && slot.ops != nullptr)
+			slot.ops->destroy(slot.p);
+		slot.exist = false;
+		slot.ops = nullptr;
+	}
+
+	void DynamicTreeBlob::Free(Slot& slot)
+	{
+		Destroy(slot);
+		if (slot.p == nullptr)
+			return;
+		if (pooled)
+			BlobPool::Deallocate(slot.p, slot.size);
+		else
+			::operator delete(slot.p);
+		slot = Slot{};
+	}
+
+	void DynamicTreeBlob::Release()
+	{
+		for (auto& slot : m)
+			Free(slot);
+		m.clear();
+	}
+
+	void DynamicTreeBlob::Reset()
+	{
+		for (auto& slot : m)
+			Destroy(slot);
+	}
+
 	void* DynamicTreeBlob::Allocate(const std::size_t idx, const std::size_t size)
 	{
 		if (m.size() <= idx)
-		{
 			m.resize(idx + 1);
-			e.resize(idx + 1, false);
-		}
-		auto p = std::make_unique_for_overwrite<unsigned char[]>(size);
-		auto rp = p.get();
-		std::fill_n(rp, size, 0);
-		m[idx] = std::move(p);
-		e[idx] = true;
-		return rp;
+		auto& slot = m[idx];
+		// Reuses the memory kept by Reset.
+		if (slot.p != nullptr && slot.size < size)
+			Free(slot);
+		if (slot.p == nullptr)
+			slot = { static_cast<unsigned char*>(pooled ? BlobPool::Allocate(size) : ::operator new(size)), size };
+		std::fill_n(slot.p, size, 0);
+		slot.exist = true;
+		return slot.p;
 	}
 
-	void DynamicTreeBlob::Reserve(const std::size_t cap)
+	std::size_t DynamicTreeBlob::NumReservedBytes() const
 	{
-		if (m.capacity() < cap)
+		auto n = sizeof(*this) + m.capacity() * sizeof(Slot);
+		for (const auto& slot : m)
 		{
-			m.reserve(cap);
-			e.reserve(cap);
+			if (slot.p == nullptr)
+				continue;
+			if (pooled && slot.size <= BlobPool::MaxSize)
+				n += (slot.size + BlobPoolAlign - 1) / BlobPoolAlign * BlobPoolAlign;
+			else
+				n += slot.size;
 		}
+		return n;
+	}
+
+	std::size_t DynamicTreeBlob::NumAllocations() const
+	{
+		std::size_t n = m.capacity() > 0 ? 1 : 0;
+		for (const auto& slot : m)
+			if (slot.p != nullptr && !(pooled && slot.size <= BlobPool::MaxSize))
+				++n;
+		return n;
+	}
+
+	void DynamicTreeBlob::Reserve(const std::size_t cap)
+	{
+		// Resizes in advance, so that allocations of different nodes won't touch the same memory,
+		// which is required by concurrent ticking.
+		if (m.size() < cap)
+			m.resize(cap);
 	}
 
 	bool DynamicTreeBlob::Exist(const std::size_t idx)
 	{
-		return e.size() > idx && e[idx];
+		return m.size() > idx && m[idx].exist;
 	}
 
 	void* DynamicTreeBlob::Get(const std::size_t idx)
 	{
-		return m[idx].get();
+		return m[idx].p;
+	}
+
+	void DynamicTreeBlob::Remap(const RemapPlan& plan)
+	{
+		// Blobs are moved by pointers, the plan's moves are not needed.
+		const auto&		  src = plan.src;
+		std::vector<Slot> m1(src.size());
+		for (std::size_t i = 0; i < src.size(); i++)
+			if (src[i] >= 0 && Exist(src[i]))
+				std::swap(m1[i], m[src[i]]);
+		// Drops the blobs not moved.
+		for (auto& slot : m)
+			Free(slot);
+		m.swap(m1);
+	}
+
+	// Size of a transparent huge page.
+	static constexpr std::size_t HugePageSize = 2 * 1024 * 1024;
+
+	BlobArena::BlobArena(std::size_t capacity, bool hugePages, bool lock)
+		: capacity(capacity)
+	{
+#if defined(__linux__)
+		// Maps an extra huge page to align the region, since only aligned huge pages could be backed.
+		auto size = (capacity + HugePageSize - 1) / HugePageSize * HugePageSize;
+		auto q = ::mmap(nullptr, size + HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (q == MAP_FAILED)
+			throw std::runtime_error("bt: BlobArena mmap failed");
+		auto head = reinterpret_cast<std::uintptr_t>(q);
+		auto aligned = (head + HugePageSize - 1) / HugePageSize * HugePageSize;
+		// Unmaps the unaligned head and the tail.
+		if (aligned > head)
+			::munmap(q, aligned - head);
+		if (auto tail = HugePageSize - (aligned - head); tail > 0)
+			::munmap(reinterpret_cast<void*>(aligned + size), tail);
+		p = reinterpret_cast<unsigned char*>(aligned);
+		mapped = size;
+#ifdef MADV_HUGEPAGE
+		if (hugePages && size > 0)
+			this->hugePages = ::madvise(p, size, MADV_HUGEPAGE) == 0;
+#endif
+		if (lock && size > 0)
+			locked = ::mlock(p, size) == 0;
+#else
+		p = static_cast<unsigned char*>(::operator new(capacity, std::align_val_t(ITreeBlob::BlobAlign)));
+#endif
+	}
+
+	BlobArena::~BlobArena()
+	{
+#if defined(__linux__)
+		if (locked)
+			::munlock(p, mapped);
+		::munmap(p, mapped);
+#else
+		::operator delete(p, std::align_val_t(ITreeBlob::BlobAlign));
+#endif
+	}
+
+	void* BlobArena::Allocate(std::size_t size)
+	{
+		size = (size + ITreeBlob::BlobAlign - 1) / ITreeBlob::BlobAlign * ITreeBlob::BlobAlign;
+		// Bumps only if it fits, so that a failed allocation leaves the space to smaller ones.
+		auto offset = used.load(std::memory_order_relaxed);
+		do
+		{
+			if (size > capacity - offset)
+				throw std::runtime_error("bt: BlobArena capacity not enough");
+		} while (!used.compare_exchange_weak(offset, offset + size, std::memory_order_relaxed));
+		return p + offset;
+	}
+
+	SizedTreeBlob::SizedTreeBlob(const RootNode& root, BlobArena* arena)
+		: SizedTreeBlob(root.NumNodes(), root.MaxSizeNodeBlob(), arena) {}
+
+	SizedTreeBlob::SizedTreeBlob(std::size_t numNodes, std::size_t maxSizeNodeBlob, BlobArena* arena)
+		: numNodes(numNodes), maxSizeNodeBlob(maxSizeNodeBlob), arena(arena)
+	{
+		auto n = NumBufferBytes();
+		if (arena != nullptr)
+			buf = static_cast<unsigned char*>(arena->Allocate(n));
+		else
+			buf = static_cast<unsigned char*>(::operator new(n, std::align_val_t(BlobAlign)));
+		// Cells are zeroed on allocation, only the bitmap and blob ops need to be initialized.
+		for (std::size_t i = 0; i < NumWords(); i++)
+			new (Bits() + i) BitmapWord(0);
+		std::fill_n(Ops(), numNodes, nullptr);
+	}
+
+	SizedTreeBlob::~SizedTreeBlob()
+	{
+		Destroy();
+		if (buf != nullptr && arena == nullptr)
+			::operator delete(buf, std::align_val_t(BlobAlign));
+	}
+
+	SizedTreeBlob::SizedTreeBlob(SizedTreeBlob&& o) noexcept
+		: numNodes(o.numNodes), maxSizeNodeBlob(o.maxSizeNodeBlob), buf(o.buf), arena(o.arena)
+	{
+		o.numNodes = 0;
+		o.buf = nullptr;
+	}
+
+	SizedTreeBlob& SizedTreeBlob::operator=(SizedTreeBlob&& o) noexcept
+	{
+		if (this != &o)
+		{
+			Destroy();
+			if (buf != nullptr && arena == nullptr)
+				::operator delete(buf, std::align_val_t(BlobAlign));
+			numNodes = o.numNodes;
+			maxSizeNodeBlob = o.maxSizeNodeBlob;
+			buf = o.buf;
+			arena = o.arena;
+			o.numNodes = 0;
+			o.buf = nullptr;
+		}
+		return *this;
+	}
+
+	std::size_t SizedTreeBlob::NumBufferBytes(const RootNode& root)
+	{
+		return NumBufferBytes(root.NumNodes(), root.MaxSizeNodeBlob());
+	}
+
+	std::size_t SizedTreeBlob::NumBufferBytes(std::size_t numNodes, std::size_t maxSizeNodeBlob)
+	{
+		auto stride = (maxSizeNodeBlob + BlobAlign - 1) / BlobAlign * BlobAlign;
+		// One more cell for the scratch.
+		auto n = (numNodes + 1) * stride + (numNodes + 63) / 64 * sizeof(BitmapWord)
+			+ numNodes * sizeof(const BlobOps*);
+		// Rounded up, so that buffers are packed in a BlobArena exactly.
+		return (n + BlobAlign - 1) / BlobAlign * BlobAlign;
+	}
+
+	void SizedTreeBlob::Destroy()
+	{
+		if (buf == nullptr)
+			return;
+		auto ops = Ops();
+		for (std::size_t i = 0; i < numNodes; i++)
+		{
+			if (ops[i] != nullptr && Exist(i))
+				ops[i]->destroy(Get(i));
+			ops[i] = nullptr;
+		}
+	}
+
+	void SizedTreeBlob::Reset()
+	{
+		Destroy();
+		if (buf == nullptr)
+			return;
+		for (std::size_t i = 0; i < NumWords(); i++)
+			Bits()[i].store(0, std::memory_order_relaxed);
+	}
+
+	void* SizedTreeBlob::Allocate(const std::size_t idx, const std::size_t size)
+	{
+		if (idx >= numNodes)
+			throw std::runtime_error("bt: SizedTreeBlob NumNodes not enough");
+		if (size > maxSizeNodeBlob)
+			throw std::runtime_error("bt: SizedTreeBlob MaxSizeNodeBlob not enough");
+		memset(Cell(idx), 0, size);
+		Bits()[idx >> 6].fetch_or(std::uint64_t(1) << (idx & 63), std::memory_order_release);
+		return Cell(idx);
+	}
+
+	bool SizedTreeBlob::Exist(const std::size_t idx)
+	{
+		return idx < numNodes && ((Bits()[idx >> 6].load(std::memory_order_acquire) >> (idx & 63)) & 1);
+	}
+
+	void* SizedTreeBlob::Get(const std::size_t idx)
+	{
+		return Cell(idx);
+	}
+
+	void SizedTreeBlob::Remap(const RemapPlan& plan)
+	{
+		if (plan.src.size() > numNodes)
+			throw std::runtime_error("bt: SizedTreeBlob NumNodes not enough");
+		// Relocates in place, the scratch cell is the one next to the cells.
+		RemapCells(plan, buf, Stride(), numNodes, Bits(), Ops(), Cell(numNodes));
+	}
+
+	void ITreeBlob::RemapCells(const RemapPlan& plan, unsigned char* buf, const std::size_t stride,
+		const std::size_t n, BitmapWord* bits, const BlobOps** ops, unsigned char* scratch)
+	{
+		// Remapping is not concurrent with ticking, relaxed order is enough.
+		auto exist = [&](int i) {
+			if (i < 0 || static_cast<std::size_t>(i) >= n)
+				return false;
+			return static_cast<bool>((bits[i >> 6].load(std::memory_order_relaxed) >> (i & 63)) & 1);
+		};
+		auto occupy = [&](int i) { bits[i >> 6].fetch_or(std::uint64_t(1) << (i & 63), std::memory_order_relaxed); };
+		auto vacate = [&](int i) {
+			bits[i >> 6].fetch_and(~(std::uint64_t(1) << (i & 63)), std::memory_order_relaxed);
+			ops[i] = nullptr;
+		};
+		for (auto i : plan.drops)
+		{
+			if (!exist(i))
+				continue;
+			if (ops[i] != nullptr)
+				ops[i]->destroy(buf + i * stride);
+			vacate(i);
+		}
+		// Whether the scratch cell holds a blob, and its ops.
+		bool		   scratchExist = false;
+		const BlobOps* scratchOps = nullptr;
+		for (auto [to, from] : plan.moves)
+		{
+			if (to < 0) // to the scratch.
+			{
+				if ((scratchExist = exist(from)))
+				{
+					scratchOps = ops[from];
+					Relocate(scratch, buf + from * stride, stride, scratchOps);
+					vacate(from);
+				}
+				continue;
+			}
+			if (from < 0) // from the scratch.
+			{
+				if (scratchExist)
+				{
+					Relocate(buf + to * stride, scratch, stride, scratchOps);
+					occupy(to);
+					ops[to] = scratchOps;
+					scratchExist = false;
+				}
+				continue;
+			}
+			if (!exist(from))
+				continue;
+			Relocate(buf + to * stride, buf + from * stride, stride, ops[from]);
+			occupy(to);
+			ops[to] = ops[from];
+			vacate(from);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////
+	/// Profiling
+	///////////////////////////////////////////////////////////////
+
+#ifdef BT_ENABLE_PROFILING
+
+	// Counters of a node on a thread.
+	// Written by the owner thread only, read by the collectors, so relaxed load and store are enough.
+	struct ProfileCounters
+	{
+		std::atomic<ull> calls = 0;
+		std::atomic<ull> statuses[4] = {};
+		std::atomic<ull> self = 0;
+		std::atomic<ull> inclusive = 0;
+		std::atomic<ull> histogram[NodeProfile::NumBuckets] = {};
+	};
+
+	static inline void ProfileAdd(std::atomic<ull>& a, ull x)
+	{
+		a.store(a.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+	}
+
+	// Profiling storage of a thread.
+	struct ThreadProfile
+	{
+		static constexpr std::size_t ChunkSize = 64;
+
+		struct Frame
+		{
+			Timepoint startAt;
+			ull		  children = 0; // inclusive time of the children.
+		};
+
+		// Guards the growth of chunks against the collectors.
+		std::mutex mu;
+		// Counters indexed by slot, in chunks, so that the growth doesn't move them.
+		std::vector<std::unique_ptr<ProfileCounters[]>> chunks;
+		// Ticking stack of the owner thread, for self time.
+		std::vector<Frame> stack;
+		// Is owned by a living thread? guarded by the registry's mutex.
+		bool inUse = false;
+
+		ProfileCounters& At(unsigned int slot)
+		{
+			auto c = slot / ChunkSize;
+			if (c >= chunks.size())
+			{
+				std::lock_guard lock(mu);
+				while (chunks.size() <= c)
+					chunks.push_back(std::make_unique<ProfileCounters[]>(ChunkSize));
+			}
+			return chunks[c][slot % ChunkSize];
+		}
+	};
+
+	struct ProfileSlotInfo
+	{
+		std::string	 name;
+		NodeId		 id = 0;
+		StableNodeId stableId = 0;
+	};
+
+	// Global registry of profiling slots and thread storages.
+	struct ProfileRegistry
+	{
+		std::mutex								 mu;
+		std::vector<ProfileSlotInfo>			 slots{ 1 }; // slot 0 is reserved for none.
+		std::vector<unsigned int>				 freeSlots; // released by destroyed nodes, for reuse.
+		std::vector<std::unique_ptr<ThreadProfile>> threads;
+	};
+
+	static ProfileRegistry& GetProfileRegistry()
+	{
+		// Never destroyed, nodes of static trees release their slots on exit.
+		static auto r = new ProfileRegistry();
+		return *r;
+	}
+
+	// Binds a thread storage to current thread, it's released for reuse on thread exit.
+	struct ThreadProfileHandle
+	{
+		ThreadProfile* p = nullptr;
+
+		ThreadProfileHandle()
+		{
+			auto&		r = GetProfileRegistry();
+			std::lock_guard lock(r.mu);
+			for (auto& t : r.threads)
+				if (!t->inUse)
+				{
+					p = t.get();
+					break;
+				}
+			if (p == nullptr)
+				p = r.threads.emplace_back(std::make_unique<ThreadProfile>()).get();
+			p->inUse = true;
+			p->stack.reserve(64);
+		}
+
+		~ThreadProfileHandle()
+		{
+			std::lock_guard lock(GetProfileRegistry().mu);
+			p->stack.clear();
+			p->inUse = false;
+		}
+	};
+
+	static thread_local ThreadProfileHandle threadProfile;
+
+	// Registers a slot for a node, or updates its info if already registered.
+	static void RegisterProfileSlot(unsigned int& slot, std::string_view name, NodeId id, StableNodeId stableId)
+	{
+		auto&		r = GetProfileRegistry();
+		std::lock_guard lock(r.mu);
+		if (slot == 0 && !r.freeSlots.empty())
+		{
+			slot = r.freeSlots.back();
+			r.freeSlots.pop_back();
+		}
+		else if (slot == 0)
+		{
+			slot = static_cast<unsigned int>(r.slots.size());
+			r.slots.emplace_back();
+		}
+		r.slots[slot] = { std::string(name), id, stableId };
+	}
+
+	static void ClearProfileCounters(ProfileCounters& x)
+	{
+		x.calls.store(0, std::memory_order_relaxed);
+		for (auto& a : x.statuses)
+			a.store(0, std::memory_order_relaxed);
+		x.self.store(0, std::memory_order_relaxed);
+		x.inclusive.store(0, std::memory_order_relaxed);
+		for (auto& a : x.histogram)
+			a.store(0, std::memory_order_relaxed);
+	}
+
+	// Releases a slot of a destroyed node, its counters are cleared on all threads for the next owner.
+	static void ReleaseProfileSlot(unsigned int slot)
+	{
+		auto&		r = GetProfileRegistry();
+		std::lock_guard lock(r.mu);
+		for (auto& t : r.threads)
+		{
+			std::lock_guard lock1(t->mu);
+			auto			c = slot / ThreadProfile::ChunkSize;
+			if (c < t->chunks.size())
+				ClearProfileCounters(t->chunks[c][slot % ThreadProfile::ChunkSize]);
+		}
+		r.slots[slot] = {};
+		r.freeSlots.push_back(slot);
+	}
+
+	// ProfileScope records a Node::Tick call on destruction.
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(unsigned int slot)
+			: slot(slot)
+		{
+			if (slot)
+				threadProfile.p->stack.push_back({ std::chrono::steady_clock::now(), 0 });
+		}
+
+		~ProfileScope()
+		{
+			if (!slot)
+				return;
+			auto  t = threadProfile.p;
+			auto  frame = t->stack.back();
+			ull	  d = (std::chrono::steady_clock::now() - frame.startAt).count();
+			t->stack.pop_back();
+			if (!t->stack.empty())
+				t->stack.back().children += d;
+
+			auto& c = t->At(slot);
+			auto  bucket = std::min<std::size_t>(d ? std::bit_width(d) - 1 : 0, NodeProfile::NumBuckets - 1);
+			ProfileAdd(c.calls, 1);
+			ProfileAdd(c.statuses[static_cast<int>(status)], 1);
+			ProfileAdd(c.inclusive, d);
+			ProfileAdd(c.self, d - std::min(d, frame.children));
+			ProfileAdd(c.histogram[bucket], 1);
+		}
+
+		Status status = Status::UNDEFINED;
+
+	private:
+		unsigned int slot;
+	};
+
+#endif
+
+	std::chrono::nanoseconds NodeProfile::Percentile(double p) const
+	{
+		if (calls == 0)
+			return std::chrono::nanoseconds(0);
+		auto target = std::max<ull>(1, static_cast<ull>(p * calls + 0.5));
+		ull	 cnt = 0;
+		for (std::size_t i = 0; i < NumBuckets; i++)
+		{
+			cnt += histogram[i];
+			if (cnt >= target)
+				return std::chrono::nanoseconds(1LL << (i + 1));
+		}
+		return std::chrono::nanoseconds(1LL << NumBuckets);
+	}
+
+	std::vector<NodeProfile> Profiler::Collect(SortBy by)
+	{
+		std::vector<NodeProfile> profiles;
+#ifdef BT_ENABLE_PROFILING
+		auto&		r = GetProfileRegistry();
+		std::lock_guard lock(r.mu);
+		profiles.resize(r.slots.size());
+		for (auto& t : r.threads)
+		{
+			std::lock_guard lock1(t->mu);
+			for (std::size_t c = 0; c < t->chunks.size(); c++)
+			{
+				for (std::size_t j = 0; j < ThreadProfile::ChunkSize; j++)
+				{
+					auto slot = c * ThreadProfile::ChunkSize + j;
+					if (slot >= profiles.size())
+						break;
+					auto& x = t->chunks[c][j];
+					auto& p = profiles[slot];
+					p.calls += x.calls.load(std::memory_order_relaxed);
+					for (int k = 0; k < 4; k++)
+						p.statuses[k] += x.statuses[k].load(std::memory_order_relaxed);
+					p.self += std::chrono::nanoseconds(x.self.load(std::memory_order_relaxed));
+					p.inclusive += std::chrono::nanoseconds(x.inclusive.load(std::memory_order_relaxed));
+					for (std::size_t k = 0; k < NodeProfile::NumBuckets; k++)
+						p.histogram[k] += x.histogram[k].load(std::memory_order_relaxed);
+				}
+			}
+		}
+		for (std::size_t slot = 0; slot < profiles.size(); slot++)
+		{
+			profiles[slot].name = r.slots[slot].name;
+			profiles[slot].id = r.slots[slot].id;
+			profiles[slot].stableId = r.slots[slot].stableId;
+		}
+		// Drops the ones never ticked, including the reserved slot 0.
+		std::erase_if(profiles, [](const NodeProfile& p) { return p.calls == 0; });
+#endif
+		std::stable_sort(profiles.begin(), profiles.end(), [by](const NodeProfile& a, const NodeProfile& b) {
+			return by == SortBy::Self ? a.self > b.self : a.inclusive > b.inclusive;
+		});
+		return profiles;
+	}
+
+	std::string Profiler::Report(SortBy by, std::size_t limit)
+	{
+		auto profiles = Collect(by);
+		if (limit > 0 && profiles.size() > limit)
+			profiles.resize(limit);
+
+		char		buf[256];
+		std::string s;
+		snprintf(buf, sizeof(buf), "%-24s %6s %10s %12s %12s %10s %10s %10s %10s %10s\n", "Name", "Id", "Calls",
+			"Self(us)", "Incl(us)", "P50(us)", "P99(us)", "Running", "Success", "Failure");
+		s += buf;
+		for (const auto& p : profiles)
+		{
+			snprintf(buf, sizeof(buf), "%-24.24s %6u %10llu %12.1f %12.1f %10.1f %10.1f %10llu %10llu %10llu\n",
+				p.name.c_str(), p.id, p.calls, p.self.count() / 1e3, p.inclusive.count() / 1e3,
+				p.Percentile(0.5).count() / 1e3, p.Percentile(0.99).count() / 1e3,
+				p.statuses[static_cast<int>(Status::RUNNING)], p.statuses[static_cast<int>(Status::SUCCESS)],
+				p.statuses[static_cast<int>(Status::FAILURE)]);
+			s += buf;
+		}
+		return s;
+	}
+
+	void Profiler::Reset()
+	{
+#ifdef BT_ENABLE_PROFILING
+		auto&		r = GetProfileRegistry();
+		std::lock_guard lock(r.mu);
+		for (auto& t : r.threads)
+		{
+			std::lock_guard lock1(t->mu);
+			for (auto& chunk : t->chunks)
+				for (std::size_t j = 0; j < ThreadProfile::ChunkSize; j++)
+					ClearProfileCounters(chunk[j]);
+		}
+#endif
+	}
+
+	std::size_t Profiler::NumSlots()
+	{
+#ifdef BT_ENABLE_PROFILING
+		auto&		r = GetProfileRegistry();
+		std::lock_guard lock(r.mu);
+		return r.slots.size() - 1;
+#else
+		return 0;
+#endif
+	}
+
+	void ProfileSlot::Release()
+	{
+#ifdef BT_ENABLE_PROFILING
+		if (index)
+			ReleaseProfileSlot(index);
+#endif
+		index = 0;
+	}
+
+	////////////////////////////
+	/// Batch
+	////////////////////////////
+
+	void BatchMask::Clear(std::size_t first, std::size_t last)
+	{
+		for (; first < last && (first & 63); first++)
+			words[first >> 6] &= ~(std::uint64_t(1) << (first & 63));
+		for (; first + 64 <= last; first += 64)
+			words[first >> 6] = 0;
+		for (; first < last; first++)
+			words[first >> 6] &= ~(std::uint64_t(1) << (first & 63));
 	}
 
 	////////////////////////////
 	/// Node
 	////////////////////////////
 
+	// Returns name of given status.
+	static const char* StatusName(Status s)
+	{
+		static const char* names[] = { "UNDEFINED", "RUNNING", "SUCCESS", "FAILURE" };
+		return names[static_cast<int>(s)];
+	}
+
 	// Returns char representation of given status.
 	static const char StatusRepr(Status s)
 	{
@@ -83,7 +936,11 @@ namespace bt
 
 	void Node::MakeVisualizeString(std::string& s, int depth, ull seq)
 	{
-		const auto* b = GetNodeBlob();
+		// Never allocates blobs for visualization.
+		static const NodeBlob emptyBlob;
+		const auto*			  b = root->GetTreeBlob()->Peek(id);
+		if (b == nullptr)
+			b = &emptyBlob;
 		if (depth > 0)
 			s += " |";
 		for (int i = 1; i < depth; i++)
@@ -113,6 +970,30 @@ namespace bt
 		return priorityCurrentTick;
 	}
 
+	// Returns the bytes of heap memory owned by given string, 0 if it's stored inline.
+	static std::size_t StringHeapSize(const std::string& s)
+	{
+		static const std::size_t inlineCapacity = std::string().capacity();
+		return s.capacity() > inlineCapacity ? s.capacity() + 1 : 0;
+	}
+
+	// Returns the bytes of heap memory owned by given vector.
+	template <typename T>
+	static std::size_t VectorHeapSize(const std::vector<T>& v)
+	{
+		return v.capacity() * sizeof(T);
+	}
+
+	static std::size_t VectorHeapSize(const std::vector<bool>& v)
+	{
+		return (v.capacity() + 7) / 8;
+	}
+
+	std::size_t Node::HeapSize() const
+	{
+		return StringHeapSize(name);
+	}
+
 	void Node::Traverse(TraversalCallback& pre, TraversalCallback& post, Ptr<Node>& ptr)
 	{
 		pre(*this, ptr);
@@ -121,6 +1002,13 @@ namespace bt
 
 	Status Node::Tick(const Context& ctx)
 	{
+#ifdef BT_ENABLE_PROFILING
+		ProfileScope scope(profileSlot.index);
+#endif
+		Timepoint startAt;
+		if (traceRecorder != nullptr)
+			startAt = std::chrono::steady_clock::now();
+
 		auto b = GetNodeBlob();
 		// First run of current round.
 		if (!b->running)
@@ -130,6 +1018,11 @@ namespace bt
 		auto status = Update(ctx);
 		b->lastStatus = status;
 		b->lastSeq = ctx.seq;
+#ifdef BT_ENABLE_PROFILING
+		scope.status = status;
+#endif
+		if (traceRecorder != nullptr)
+			traceRecorder->Record(ctx.seq, id, status, startAt, std::chrono::steady_clock::now());
 
 		// Last run of current round.
 		if (status == Status::FAILURE || status == Status::SUCCESS)
@@ -140,6 +1033,53 @@ namespace bt
 		return status;
 	}
 
+	void Node::TickBatch(Batch& batch, std::span<const std::size_t> indices)
+	{
+		// Node blobs of the entities are kept on the stack during UpdateBatch.
+		auto& blobs = *batch.nodeBlobs;
+		auto  base = blobs.size();
+
+		for (auto i : indices)
+		{
+			batch.Bind(i);
+			auto b = GetNodeBlob();
+			blobs.push_back(b);
+			// First run of current round.
+			if (!b->running)
+				OnEnter(batch.contexts[i]);
+			b->running = true;
+		}
+
+		UpdateBatch(batch, indices);
+
+		for (std::size_t k = 0; k < indices.size(); k++)
+		{
+			auto  i = indices[k];
+			auto  b = blobs[base + k];
+			auto& ctx = batch.contexts[i];
+			auto  status = batch.statuses[i];
+			b->lastStatus = status;
+			b->lastSeq = ctx.seq;
+			// Last run of current round.
+			if (status == Status::FAILURE || status == Status::SUCCESS)
+			{
+				batch.Bind(i);
+				OnTerminate(ctx, status);
+				b->running = false; // reset
+			}
+		}
+		blobs.resize(base);
+	}
+
+	void Node::UpdateBatch(Batch& batch, std::span<const std::size_t> indices)
+	{
+		for (auto i : indices)
+		{
+			batch.Bind(i);
+			batch.statuses[i] = Update(batch.contexts[i]);
+		}
+	}
+
 	////////////////////////////////////
 	/// Node > LeafNode > ConditionNode
 	/////////////////////////////////////
@@ -157,6 +1097,194 @@ namespace bt
 		return checker != nullptr && checker(ctx);
 	}
 
+	void ConditionNode::CheckBatch(std::span<const Context> contexts, std::span<const std::size_t> indices,
+		BatchMask& out)
+	{
+		for (auto i : indices)
+			if (Check(contexts[i]))
+				out.Set(i);
+	}
+
+	std::size_t ConditionNode::HeapSize() const
+	{
+		return LeafNode::HeapSize() + mask.NumWords() * sizeof(std::uint64_t);
+	}
+
+	void ConditionNode::UpdateBatch(Batch& batch, std::span<const std::size_t> indices)
+	{
+		if (mask.Size() != batch.contexts.size())
+			mask.Reset(batch.contexts.size());
+		mask.Clear(indices.front(), indices.back() + 1);
+		CheckBatch(batch.contexts, indices, mask);
+		for (auto i : indices)
+			batch.statuses[i] = mask.Test(i) ? Status::SUCCESS : Status::FAILURE;
+	}
+
+	/////////////////////////////////////////////////////////////
+	/// Node > LeafNode > ConditionNode > CachedConditionNode
+	/////////////////////////////////////////////////////////////
+
+	CachedConditionNode::CachedConditionNode(std::vector<std::size_t> dependencies, Checker checker,
+		std::string_view name)
+		: ConditionNode(checker, name), dependencies(std::move(dependencies)) {}
+
+	std::size_t CachedConditionNode::HeapSize() const
+	{
+		return ConditionNode::HeapSize() + VectorHeapSize(dependencies);
+	}
+
+	Status CachedConditionNode::Update(const Context& ctx)
+	{
+		auto b = GetNodeBlobHelper<Blob>();
+		auto bb = ctx.blackboard;
+
+		if (bb != nullptr && b->valid)
+		{
+			bool changed = false;
+			for (auto slot : dependencies)
+			{
+				if (bb->Version(slot) > b->seen)
+				{
+					changed = true;
+					break;
+				}
+			}
+			if (!changed)
+			{
+				hits.fetch_add(1, std::memory_order_relaxed);
+				return b->result ? Status::SUCCESS : Status::FAILURE;
+			}
+		}
+
+		misses.fetch_add(1, std::memory_order_relaxed);
+		bool result = Check(ctx);
+		if (bb != nullptr)
+		{
+			b->valid = true;
+			b->result = result;
+			b->seen = bb->Clock();
+		}
+		return result ? Status::SUCCESS : Status::FAILURE;
+	}
+
+	/////////////////////////////////////////////////////////
+	/// Node > LeafNode > ActionNode > CoroutineActionNode
+	/////////////////////////////////////////////////////////
+
+	void* Coroutine::promise_type::operator new(std::size_t size)
+	{
+		return BlobPool::Allocate(size);
+	}
+
+	void Coroutine::promise_type::operator delete(void* p, std::size_t size)
+	{
+		// Frames may be destroyed on another thread, or after the allocating thread exits, which BlobPool handles.
+		BlobPool::Deallocate(p, size);
+	}
+
+	Coroutine::Awaiter Coroutine::promise_type::await_transform(NextTickTag)
+	{
+		wait = Wait::TICK;
+		return { *this };
+	}
+
+	Coroutine::Awaiter Coroutine::promise_type::await_transform(DelayTag d)
+	{
+		wait = Wait::TIMEPOINT;
+		wakeAt = std::chrono::steady_clock::now() + d.duration;
+		return { *this };
+	}
+
+	Coroutine::Awaiter Coroutine::promise_type::await_transform(const Signal& s)
+	{
+		wait = Wait::SIGNAL;
+		signal = &s;
+		signalVersion = s.Version();
+		return { *this };
+	}
+
+	bool Coroutine::promise_type::Ready() const
+	{
+		switch (wait)
+		{
+			case Wait::TIMEPOINT:
+				return std::chrono::steady_clock::now() >= wakeAt;
+			case Wait::SIGNAL:
+				return signal->Version() != signalVersion;
+			default:
+				return true;
+		}
+	}
+
+	Coroutine::~Coroutine()
+	{
+		if (h)
+			h.destroy();
+	}
+
+	Status CoroutineActionNode::Update(const Context& ctx)
+	{
+		auto b = GetNodeBlobHelper<Blob>();
+		if (!b->handle)
+			b->handle = Run(ctx).Release();
+		auto& promise = b->handle.promise();
+		if (!promise.Ready())
+			return Status::RUNNING;
+		promise.ctx = &ctx;
+		try
+		{
+			b->handle.resume();
+		}
+		catch (...)
+		{
+			// The coroutine can't be resumed any more.
+			b->handle.destroy();
+			b->handle = nullptr;
+			throw;
+		}
+		if (!b->handle.done())
+			return Status::RUNNING;
+		auto status = promise.status;
+		b->handle.destroy();
+		b->handle = nullptr;
+		return status;
+	}
+
+	/////////////////////////////////////////////////////////
+	/// Node > LeafNode > ActionNode > AsyncActionNode
+	/////////////////////////////////////////////////////////
+
+	Status AsyncActionNode::Update(const Context& ctx)
+	{
+		auto b = GetNodeBlobHelper<Blob>();
+		if (b->task == nullptr)
+		{
+			auto task = std::make_shared<AsyncTask>();
+			b->task = task;
+			executor([task, work = MakeWork(ctx)]() {
+				auto status = task->Cancelled() ? Status::FAILURE : work(*task);
+				if (status != Status::SUCCESS)
+					status = Status::FAILURE;
+				task->status.store(status, std::memory_order_release);
+			});
+		}
+		// Polls the completion, the executor may have run the work inline.
+		auto status = b->task->status.load(std::memory_order_acquire);
+		if (status == Status::RUNNING)
+			return Status::RUNNING;
+		b->task = nullptr;
+		return status;
+	}
+
+	void AsyncActionNode::Cancel()
+	{
+		auto b = GetNodeBlobHelper<Blob>();
+		if (b->task == nullptr)
+			return;
+		b->task->cancelled.store(true, std::memory_order_relaxed);
+		b->task = nullptr;
+	}
+
 	////////////////////////////////////////////////
 	/// Node > InternalNode > SingleNode
 	////////////////////////////////////////////////
@@ -229,6 +1357,11 @@ namespace bt
 		post(*this, ptr);
 	}
 
+	std::size_t CompositeNode::HeapSize() const
+	{
+		return InternalNode::HeapSize() + VectorHeapSize(children);
+	}
+
 	unsigned int CompositeNode::Priority(const Context& ctx) const
 	{
 		unsigned int ans = 0;
@@ -274,6 +1407,14 @@ namespace bt
 		ptr->st.resize(children.size(), false);
 	}
 
+	std::size_t InternalStatefulCompositeNode::BlobHeapSize(const NodeBlob* blob, std::size_t& allocations) const
+	{
+		auto& st = static_cast<const Blob*>(blob)->st;
+		if (st.capacity() > 0)
+			allocations++;
+		return VectorHeapSize(st);
+	}
+
 	MixedQueueHelper::MixedQueueHelper(Cmp cmp, const std::size_t n)
 		: use1(false)
 	{
@@ -326,6 +1467,11 @@ namespace bt
 		q2.Clear();
 	}
 
+	std::size_t MixedQueueHelper::HeapSize() const
+	{
+		return VectorHeapSize(q1Container) + q2.Capacity() * sizeof(int);
+	}
+
 	void MixedQueueHelper::SetQ1Container(std::vector<int>* c)
 	{
 		q1 = c;
@@ -396,6 +1542,59 @@ namespace bt
 		return InternalUpdate(ctx);
 	}
 
+	std::size_t InternalPriorityCompositeNode::HeapSize() const
+	{
+		return CompositeNode::HeapSize() + VectorHeapSize(p) + q.HeapSize() + VectorHeapSize(simpleQ1Container)
+			+ VectorHeapSize(wave) + VectorHeapSize(ticking) + VectorHeapSize(next);
+	}
+
+	void InternalPriorityCompositeNode::UpdateBatch(Batch& batch, std::span<const std::size_t> indices)
+	{
+		// With equal priorities, every entity ticks its considerable children in order,
+		// so the entities can go through the children together.
+		// Priorities are cached per tick seq, so refreshing is only required for a new seq if all children are
+		// considerable.
+		ull seq = 0;
+		for (auto i : indices)
+		{
+			auto& ctx = batch.contexts[i];
+			if (IsParatialConsidered() || ctx.seq != seq || seq == 0)
+			{
+				batch.Bind(i);
+				Refresh(ctx);
+				seq = ctx.seq;
+			}
+			if (!areAllEqual)
+				return Node::UpdateBatch(batch, indices);
+		}
+		InternalUpdateBatch(batch, indices);
+	}
+
+	void InternalPriorityCompositeNode::InternalUpdateBatch(Batch& batch, std::span<const std::size_t> indices)
+	{
+		Node::UpdateBatch(batch, indices);
+	}
+
+	void InternalPriorityCompositeNode::SplitConsiderable(Batch& batch, int i, std::span<const std::size_t> indices,
+		std::vector<std::size_t>& considered, std::vector<std::size_t>& skipped)
+	{
+		considered.clear();
+		skipped.clear();
+		if (!IsParatialConsidered())
+		{
+			considered.assign(indices.begin(), indices.end());
+			return;
+		}
+		for (auto k : indices)
+		{
+			batch.Bind(k);
+			if (Considerable(i))
+				considered.push_back(k);
+			else
+				skipped.push_back(k);
+		}
+	}
+
 	//////////////////////////////////////////////////////////////
 	/// Node > InternalNode > CompositeNode > SequenceNode
 	///////////////////////////////////////////////////////////////
@@ -425,6 +1624,41 @@ namespace bt
 		return Status::SUCCESS;
 	}
 
+	void InternalSequenceNodeBase::InternalUpdateBatch(Batch& batch, std::span<const std::size_t> indices)
+	{
+		wave.assign(indices.begin(), indices.end());
+		for (int i = 0; i < children.size() && !wave.empty(); i++)
+		{
+			SplitConsiderable(batch, i, wave, ticking, next);
+			if (ticking.empty())
+				continue;
+			children[i]->TickBatch(batch, ticking);
+			auto mid = next.size();
+			// Entities stopped at this child keep its status, R or F.
+			for (auto k : ticking)
+			{
+				auto status = batch.statuses[k];
+				if (status == Status::RUNNING)
+					continue;
+				batch.Bind(k);
+				if (status == Status::FAILURE)
+				{
+					OnChildFailure(i);
+					continue;
+				}
+				// S
+				OnChildSuccess(i);
+				next.push_back(k);
+			}
+			// Skipped ones and succeeded ones go on, keeping the orders.
+			std::inplace_merge(next.begin(), next.begin() + mid, next.end());
+			wave.swap(next);
+		}
+		// S if all children S.
+		for (auto k : wave)
+			batch.statuses[k] = Status::SUCCESS;
+	}
+
 	StatefulSequenceNode::StatefulSequenceNode(std::string_view name, PtrList<Node>&& cs)
 		: CompositeNode(name, std::move(cs)), InternalPriorityCompositeNode() {}
 
@@ -462,6 +1696,41 @@ namespace bt
 		return Status::FAILURE;
 	}
 
+	void InternalSelectorNodeBase::InternalUpdateBatch(Batch& batch, std::span<const std::size_t> indices)
+	{
+		wave.assign(indices.begin(), indices.end());
+		for (int i = 0; i < children.size() && !wave.empty(); i++)
+		{
+			SplitConsiderable(batch, i, wave, ticking, next);
+			if (ticking.empty())
+				continue;
+			children[i]->TickBatch(batch, ticking);
+			auto mid = next.size();
+			// Entities stopped at this child keep its status, R or S.
+			for (auto k : ticking)
+			{
+				auto status = batch.statuses[k];
+				if (status == Status::RUNNING)
+					continue;
+				batch.Bind(k);
+				if (status == Status::SUCCESS)
+				{
+					OnChildSuccess(i);
+					continue;
+				}
+				// F
+				OnChildFailure(i);
+				next.push_back(k);
+			}
+			// Skipped ones and failed ones go on, keeping the orders.
+			std::inplace_merge(next.begin(), next.begin() + mid, next.end());
+			wave.swap(next);
+		}
+		// F if all children F.
+		for (auto k : wave)
+			batch.statuses[k] = Status::FAILURE;
+	}
+
 	StatefulSelectorNode::StatefulSelectorNode(std::string_view name, PtrList<Node>&& cs)
 		: CompositeNode(name, std::move(cs)), InternalPriorityCompositeNode() {}
 
@@ -477,7 +1746,7 @@ namespace bt
 	RandomSelectorNode::RandomSelectorNode(std::string_view name, PtrList<Node>&& cs)
 		: CompositeNode(name, std::move(cs)), InternalPriorityCompositeNode() {}
 
-	static std::mt19937 rng(std::random_device{}()); // seed random
+	static thread_local std::mt19937 rng(std::random_device{}()); // seed random, thread local for concurrent ticking
 
 	Status InternalRandomSelectorNodeBase::Update(const Context& ctx)
 	{
@@ -553,20 +1822,55 @@ namespace bt
 		while (!q.Empty())
 		{
 			auto i = q.Pop();
-			auto status = children[i]->Tick(ctx);
+			OnChildTicked(i, children[i]->Tick(ctx), cntSuccess, cntFailure);
 			total++;
-			if (status == Status::FAILURE)
-			{
-				cntFailure++;
-				OnChildFailure(i);
-			}
-			if (status == Status::SUCCESS)
+		}
+		return Aggregate(cntSuccess, cntFailure, total);
+	}
+
+	std::size_t InternalParallelNodeBase::HeapSize() const
+	{
+		return InternalPriorityCompositeNode::HeapSize() + VectorHeapSize(counts);
+	}
+
+	void InternalParallelNodeBase::InternalUpdateBatch(Batch& batch, std::span<const std::size_t> indices)
+	{
+		// Propagates tick to all considerable children, for every entity.
+		counts.assign(batch.contexts.size(), Counts{});
+		for (int i = 0; i < children.size(); i++)
+		{
+			SplitConsiderable(batch, i, indices, ticking, next);
+			if (ticking.empty())
+				continue;
+			children[i]->TickBatch(batch, ticking);
+			for (auto k : ticking)
 			{
-				cntSuccess++;
-				OnChildSuccess(i);
+				auto& c = counts[k];
+				batch.Bind(k);
+				OnChildTicked(i, batch.statuses[k], c.success, c.failure);
+				c.total++;
 			}
 		}
+		for (auto k : indices)
+			batch.statuses[k] = Aggregate(counts[k].success, counts[k].failure, counts[k].total);
+	}
+
+	void InternalParallelNodeBase::OnChildTicked(const int i, Status status, int& cntSuccess, int& cntFailure)
+	{
+		if (status == Status::FAILURE)
+		{
+			cntFailure++;
+			OnChildFailure(i);
+		}
+		if (status == Status::SUCCESS)
+		{
+			cntSuccess++;
+			OnChildSuccess(i);
+		}
+	}
 
+	Status InternalParallelNodeBase::Aggregate(int cntSuccess, int cntFailure, int total)
+	{
 		// S if all children S.
 		if (cntSuccess == total)
 			return Status::SUCCESS;
@@ -584,6 +1888,108 @@ namespace bt
 		Skip(i);
 	}
 
+	ConcurrentParallelNode::ConcurrentParallelNode(Executor executor, std::size_t threshold, std::string_view name,
+		PtrList<Node>&& cs)
+		: CompositeNode(name, std::move(cs)), InternalPriorityCompositeNode(), executor(std::move(executor)), threshold(threshold) {}
+
+	void ConcurrentParallelNode::InternalOnBuild()
+	{
+		InternalPriorityCompositeNode::InternalOnBuild();
+		// Counts nodes of each child's subtree.
+		w.assign(children.size(), 0);
+		for (int i = 0; i < children.size(); i++)
+		{
+			TraversalCallback pre = [&](Node& node, Ptr<Node>& ptr) { w[i]++; };
+			children[i]->Traverse(pre, NullTraversalCallback, children[i]);
+		}
+		indexes.reserve(children.size());
+		statuses.resize(children.size());
+		errors.resize(children.size());
+		pending = std::make_unique<std::atomic<int>>(0);
+	}
+
+	std::size_t ConcurrentParallelNode::HeapSize() const
+	{
+		return InternalParallelNodeBase::HeapSize() + VectorHeapSize(w) + VectorHeapSize(indexes)
+			+ VectorHeapSize(statuses) + VectorHeapSize(errors) + (pending ? sizeof(*pending) : 0);
+	}
+
+	Status ConcurrentParallelNode::InternalUpdate(const Context& ctx)
+	{
+		std::size_t work = 0;
+		indexes.clear();
+		while (!q.Empty())
+		{
+			auto i = q.Pop();
+			indexes.push_back(i);
+			work += w[i];
+		}
+		int total = indexes.size();
+
+		if (executor == nullptr || total < 2 || work < threshold)
+		{
+			// Too few work, ticks sequentially.
+			for (int k = 0; k < total; k++)
+				statuses[k] = children[indexes[k]]->Tick(ctx);
+		}
+		else
+		{
+			// Dispatches children except the first one, which is ticked on this thread.
+			// The counter is owned by this node, since the last job may still notify after the join.
+			auto& pending = *this->pending;
+			pending.store(total - 1, std::memory_order_relaxed);
+			auto tick = [&](int k) {
+				try
+				{
+					statuses[k] = children[indexes[k]]->Tick(ctx);
+				}
+				catch (...)
+				{
+					errors[k] = std::current_exception();
+				}
+			};
+			auto join = [&]() {
+				for (int v = pending.load(std::memory_order_acquire); v != 0; v = pending.load(std::memory_order_acquire))
+					pending.wait(v, std::memory_order_acquire);
+			};
+			int k = 1;
+			try
+			{
+				for (; k < total; k++)
+				{
+					executor([&, k]() {
+						tick(k);
+						if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+							pending.notify_one();
+					});
+				}
+			}
+			catch (...)
+			{
+				// The dispatched jobs reference this frame, waits for them before unwinding.
+				// The failed one and the rest are never run.
+				pending.fetch_sub(total - k, std::memory_order_acq_rel);
+				join();
+				std::fill(errors.begin(), errors.begin() + k, nullptr);
+				throw;
+			}
+			tick(0);
+			join();
+			std::exception_ptr error = nullptr;
+			for (int k = 0; k < total; k++)
+				if (errors[k] != nullptr)
+					error = std::exchange(errors[k], nullptr);
+			if (error != nullptr)
+				std::rethrow_exception(error);
+		}
+
+		// Aggregates in order on this thread.
+		int cntFailure = 0, cntSuccess = 0;
+		for (int k = 0; k < total; k++)
+			OnChildTicked(indexes[k], statuses[k], cntSuccess, cntFailure);
+		return Aggregate(cntSuccess, cntFailure, total);
+	}
+
 	//////////////////////////////////////////////////////////////
 	/// Node > InternalNode > CompositeNode > Decorator
 	///////////////////////////////////////////////////////////////
@@ -608,6 +2014,17 @@ namespace bt
 		}
 	}
 
+	void InvertNode::UpdateBatch(Batch& batch, std::span<const std::size_t> indices)
+	{
+		child->TickBatch(batch, indices);
+		for (auto k : indices)
+		{
+			auto& status = batch.statuses[k];
+			if (status != Status::RUNNING)
+				status = status == Status::FAILURE ? Status::SUCCESS : Status::FAILURE;
+		}
+	}
+
 	ConditionalRunNode::ConditionalRunNode(Ptr<ConditionNode> condition,
 		std::string_view name, Ptr<Node> child)
 		: DecoratorNode(std::string(name) + '<' + std::string(condition->Name()) + '>', std::move(child)), condition(std::move(condition)) {}
@@ -629,6 +2046,26 @@ namespace bt
 		return Status::FAILURE;
 	}
 
+	std::size_t ConditionalRunNode::HeapSize() const
+	{
+		return DecoratorNode::HeapSize() + VectorHeapSize(passed);
+	}
+
+	void ConditionalRunNode::UpdateBatch(Batch& batch, std::span<const std::size_t> indices)
+	{
+		condition->TickBatch(batch, indices);
+		passed.clear();
+		for (auto i : indices)
+		{
+			if (batch.statuses[i] == Status::SUCCESS)
+				passed.push_back(i);
+			else
+				batch.statuses[i] = Status::FAILURE;
+		}
+		if (!passed.empty())
+			child->TickBatch(batch, passed);
+	}
+
 	RepeatNode::RepeatNode(int n, std::string_view name, Ptr<Node> child)
 		: DecoratorNode(name, std::move(child)), n(n) {}
 
@@ -780,16 +2217,96 @@ namespace bt
 		return (child->Update(ctx) == Status::RUNNING) ? Status::RUNNING : Status::FAILURE;
 	}
 
-	//////////////////////////////////////////////////////////////
-	/// Node > SingleNode > RootNode
-	///////////////////////////////////////////////////////////////
+	//////////////////////////////////////////////////////////////
+	/// Node > SingleNode > RootNode
+	///////////////////////////////////////////////////////////////
+
+	RootNode::RootNode(std::string_view name)
+		: SingleNode(name) {}
+
+	Status RootNode::Update(const Context& ctx)
+	{
+		return child->Tick(ctx);
+	}
+
+	void RootNode::UpdateBatch(Batch& batch, std::span<const std::size_t> indices)
+	{
+		child->TickBatch(batch, indices);
+	}
+
+	void RootNode::TickBatch(std::span<const Context> contexts, std::span<ITreeBlob* const> blobs,
+		std::span<Status> statuses, std::size_t chunk)
+	{
+		if (blobs.size() != contexts.size() || statuses.size() != contexts.size())
+			throw std::runtime_error("bt: batch size mismatch");
+		if (chunk == 0)
+			throw std::runtime_error("bt: batch chunk size must be positive");
+		batchIndices.resize(contexts.size());
+		for (std::size_t i = 0; i < batchIndices.size(); i++)
+			batchIndices[i] = i;
+
+		auto  old = blob;
+		Batch batch{ contexts, blobs, statuses, this, &batchNodeBlobs };
+		// Chunk by chunk, so that the entities' node blobs stay in cache during a wavefront.
+		std::span<const std::size_t> all(batchIndices);
+		for (std::size_t s = 0; s < all.size(); s += chunk)
+			TickBatch(batch, all.subspan(s, std::min(chunk, all.size() - s)));
+		blob = old;
+	}
+
+	MemoryReport RootNode::ReportMemory(ITreeBlob* b)
+	{
+		MemoryReport report;
+		report.numNodes = n;
+		report.nodeBytes = treeSize;
+		std::size_t		  blobAllocations = 0;
+		TraversalCallback pre = [&](Node& node, Ptr<Node>& ptr) {
+			report.nodeHeapBytes += node.HeapSize();
+			report.blobFullBytes += node.BlobSize();
+			auto blob = b != nullptr ? b->Peek(node.Id()) : nullptr;
+			if (blob != nullptr)
+			{
+				report.blobUsedBytes += node.BlobSize();
+				report.blobHeapBytes += node.BlobHeapSize(blob, blobAllocations);
+			}
+		};
+		Traverse(pre, NullTraversalCallback, NullNodePtr);
+		if (b != nullptr)
+		{
+			report.blobReservedBytes = b->NumReservedBytes();
+			report.blobPaddingBytes = report.blobReservedBytes - report.blobUsedBytes;
+			report.blobAllocations = b->NumAllocations() + blobAllocations;
+		}
+		return report;
+	}
+
+	std::size_t RootNode::HeapSize() const
+	{
+		// Nodes of the hash table are estimated as a value and a next pointer each.
+		return SingleNode::HeapSize() + VectorHeapSize(batchIndices) + VectorHeapSize(batchNodeBlobs)
+			+ VectorHeapSize(stableIds) + nodeIds.bucket_count() * sizeof(void*)
+			+ nodeIds.size() * (sizeof(decltype(nodeIds)::value_type) + sizeof(void*));
+	}
+
+	void RootNode::BindTraceRecorder(TraceRecorder& r)
+	{
+		recorder = &r;
+		// Caches the pointer on every node.
+		TraversalCallback pre = [&](Node& node, Ptr<Node>& ptr) { node.traceRecorder = recorder; };
+		Traverse(pre, NullTraversalCallback, NullNodePtr);
+	}
 
-	RootNode::RootNode(std::string_view name)
-		: SingleNode(name) {}
+	void RootNode::UnbindTraceRecorder()
+	{
+		recorder = nullptr;
+		TraversalCallback pre = [&](Node& node, Ptr<Node>& ptr) { node.traceRecorder = nullptr; };
+		Traverse(pre, NullTraversalCallback, NullNodePtr);
+	}
 
-	Status RootNode::Update(const Context& ctx)
+	NodeId RootNode::FindNodeId(StableNodeId stableId) const
 	{
-		return child->Tick(ctx);
+		auto it = nodeIds.find(stableId);
+		return it == nodeIds.end() ? 0 : it->second;
 	}
 
 	void RootNode::Visualize(ull seq)
@@ -830,6 +2347,120 @@ namespace bt
 		}
 	}
 
+	void RootNode::TickForever(Context& ctx, FixedTicker& ticker, bool visualize,
+		std::function<void(const Context&)> post)
+	{
+		ticker.Run([&](std::chrono::nanoseconds delta) {
+			ctx.delta = delta;
+			++ctx.seq;
+			Tick(ctx);
+			if (post != nullptr)
+				post(ctx);
+			if (visualize)
+				Visualize(ctx.seq);
+		});
+	}
+
+	//////////////////////////////////////////////////////////////
+	/// TreeBlob Migration
+	///////////////////////////////////////////////////////////////
+
+	TreeBlobMigration::TreeBlobMigration(RootNode& from, RootNode& to)
+	{
+		// Signature of a node to tell whether its blob is compatible across trees.
+		struct Signature
+		{
+			NodeId				  id = 0;
+			const std::type_info* blobType = nullptr;
+			std::vector<StableNodeId> children;
+		};
+
+		// Collects signatures of all nodes in given tree, by stable id.
+		auto collect = [](RootNode& root) {
+			std::unordered_map<StableNodeId, Signature> signatures;
+			std::vector<Signature*>						stack;
+			TraversalCallback							pre = [&](Node& node, Ptr<Node>& ptr) {
+				  if (!stack.empty())
+					  stack.back()->children.push_back(node.StableId());
+				  auto& sig = signatures[node.StableId()];
+				  sig.id = node.Id();
+				  sig.blobType = node.blobType;
+				  stack.push_back(&sig);
+			};
+			TraversalCallback post = [&](Node& node, Ptr<Node>& ptr) { stack.pop_back(); };
+			root.Traverse(pre, post, NullNodePtr);
+			return signatures;
+		};
+
+		auto a = collect(from);
+		auto b = collect(to);
+
+		auto& src = plan.src;
+		src.assign(to.NumNodes(), -1);
+		for (const auto& [stableId, sig] : b)
+		{
+			auto it = a.find(stableId);
+			if (it == a.end())
+				continue;
+			const auto& old = it->second;
+			if (old.blobType == nullptr || sig.blobType == nullptr || *old.blobType != *sig.blobType
+				|| old.children != sig.children)
+				continue;
+			src[sig.id - 1] = old.id - 1;
+			numKept++;
+		}
+
+		// dst[j] is the index in new tree to move the blob at index j in old tree to, -1 for none.
+		std::vector<int> dst(from.NumNodes(), -1);
+		for (int i = 0; i < static_cast<int>(src.size()); i++)
+			if (src[i] >= 0)
+				dst[src[i]] = i;
+		for (int j = 0; j < static_cast<int>(dst.size()); j++)
+			if (dst[j] < 0)
+				plan.drops.push_back(j);
+
+		// The moves form chains and cycles. A chain ends at a vacated index, it's moved from the end backwards.
+		// A cycle is broken by moving one blob to the scratch first.
+		auto moving = [&](int j) { return j < static_cast<int>(dst.size()) && dst[j] >= 0 && dst[j] != j; };
+		std::vector<bool> visited(dst.size(), false);
+		std::vector<int>  chain;
+		for (int j = 0; j < static_cast<int>(dst.size()); j++)
+		{
+			// Starts of chains: nothing moves to them.
+			if (!moving(j) || (j < static_cast<int>(src.size()) && src[j] >= 0))
+				continue;
+			chain.clear();
+			for (int k = j; moving(k); k = dst[k])
+			{
+				visited[k] = true;
+				chain.push_back(k);
+			}
+			for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+				plan.moves.push_back({ dst[*it], *it });
+		}
+		for (int j = 0; j < static_cast<int>(dst.size()); j++)
+		{
+			// The rest are cycles.
+			if (!moving(j) || visited[j])
+				continue;
+			chain.clear();
+			for (int k = j; !visited[k]; k = dst[k])
+			{
+				visited[k] = true;
+				chain.push_back(k);
+			}
+			plan.moves.push_back({ -1, chain.back() });
+			for (auto it = chain.rbegin() + 1; it != chain.rend(); ++it)
+				plan.moves.push_back({ dst[*it], *it });
+			plan.moves.push_back({ j, -1 });
+		}
+	}
+
+	void TreeBlobMigration::Apply(ITreeBlob& blob) const
+	{
+		blob.Remap(plan);
+	}
+
 	//////////////////////////////////////////////////////////////
 	/// Tree Builder
 	///////////////////////////////////////////////////////////////
@@ -837,13 +2468,20 @@ namespace bt
 	void InternalBuilderBase::MaintainNodeBindInfo(Node& node, RootNode* root)
 	{
 		node.root = root;
+		node.traceRecorder = root->recorder;
 		root->n++;
 		node.id = ++nextNodeId;
 	}
+
+	void InternalBuilderBase::MaintainNodeBlobInfo(Node& node, const std::type_info& blobType)
+	{
+		node.blobType = &blobType;
+	}
 	void InternalBuilderBase::MaintainSizeInfoOnRootBind(RootNode* root, std::size_t rootNodeSize,
 		std::size_t blobSize)
 	{
 		root->size = rootNodeSize;
+		root->blobSize = blobSize;
 		root->treeSize += rootNodeSize;
 		root->maxSizeNode = rootNodeSize;
 		root->maxSizeNodeBlob = blobSize;
@@ -856,9 +2494,11 @@ namespace bt
 		root->maxSizeNodeBlob = std::max(root->maxSizeNodeBlob, subtree.maxSizeNodeBlob);
 	}
 
-	void InternalBuilderBase::OnRootAttach(RootNode* root, std::size_t size, std::size_t blobSize)
+	void InternalBuilderBase::OnRootAttach(RootNode* root, std::size_t size, std::size_t blobSize,
+		const std::type_info& blobType)
 	{
 		MaintainNodeBindInfo(*root, root);
+		MaintainNodeBlobInfo(*root, blobType);
 		MaintainSizeInfoOnRootBind(root, size, blobSize);
 	}
 
@@ -880,6 +2520,7 @@ namespace bt
 		std::size_t nodeBlobSize)
 	{
 		node.size = nodeSize;
+		node.blobSize = nodeBlobSize;
 		root->treeSize += nodeSize;
 		root->maxSizeNode = std::max(root->maxSizeNode, nodeSize);
 		root->maxSizeNodeBlob = std::max(root->maxSizeNodeBlob, nodeBlobSize);
@@ -926,6 +2567,7 @@ namespace bt
 	void InternalBuilderBase::AttachLeafNode(Ptr<LeafNode> p)
 	{
 		Adjust();
+		last = p.get();
 		// Append to stack's top as a child.
 		OnNodeBuild(p.get());
 		stack.top()->Append(std::move(p));
@@ -938,12 +2580,78 @@ namespace bt
 		Adjust();
 		// Append to stack's top as a child, and replace the top.
 		auto parent = stack.top();
+		last = p.get();
 		stack.push(p.get()); // cppcheck-suppress danglingLifetime
 		parent->Append(std::move(p));
 		// resets level.
 		level = 1;
 	}
 
+	// FNV-1a hash, which is stable across platforms and runs.
+	static StableNodeId Fnv1a(std::string_view s, StableNodeId h = 14695981039346656037ULL)
+	{
+		for (auto c : s)
+		{
+			h ^= static_cast<unsigned char>(c);
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+
+	void InternalBuilderBase::SetKey(std::string_view key)
+	{
+		if (last == nullptr)
+			throw std::runtime_error("bt build: no node to set key");
+		last->key = Fnv1a(key);
+	}
+
+	void InternalBuilderBase::MaintainStableIds(RootNode* root)
+	{
+		struct Frame
+		{
+			StableNodeId stableId;
+			// number of visited children by name, for ordinals among the siblings with the same name.
+			std::vector<std::pair<std::string_view, int>> ordinals;
+		};
+		std::vector<Frame> stack;
+
+		root->stableIds.assign(root->n, 0);
+		root->nodeIds.clear();
+
+		TraversalCallback pre = [&](Node& node, Ptr<Node>& ptr) {
+			auto stableId = node.key;
+			if (!stableId)
+			{
+				// Derives from the parent's stable id, the name and the ordinal.
+				stableId = Fnv1a("/");
+				if (!stack.empty())
+				{
+					auto& parent = stack.back();
+					auto  it = std::find_if(parent.ordinals.begin(), parent.ordinals.end(),
+						 [&](const auto& p) { return p.first == node.Name(); });
+					if (it == parent.ordinals.end())
+						it = parent.ordinals.insert(it, { node.Name(), 0 });
+					stableId = Fnv1a(node.Name(), parent.stableId);
+					stableId = Fnv1a("#" + std::to_string(it->second++), stableId);
+				}
+			}
+			if (!root->nodeIds.insert({ stableId, node.id }).second)
+			{
+				std::string s = "bt build: duplicate stable id ";
+				s += node.Name();
+				throw std::runtime_error(s);
+			}
+			node.stableId = stableId;
+			root->stableIds[node.id - 1] = stableId;
+#ifdef BT_ENABLE_PROFILING
+			RegisterProfileSlot(node.profileSlot.index, node.Name(), node.id, stableId);
+#endif
+			stack.push_back({ stableId, {} });
+		};
+		TraversalCallback post = [&](Node& node, Ptr<Node>& ptr) { stack.pop_back(); };
+		root->Traverse(pre, post, NullNodePtr);
+	}
+
 	//////////////////////////////////////////////////////////////
 	/// Tree
 	///////////////////////////////////////////////////////////////
@@ -954,4 +2662,594 @@ namespace bt
 		BindRoot(*this);
 	}
 
+	//////////////////////////////////////////////////////////////
+	/// Tick Drivers
+	///////////////////////////////////////////////////////////////
+
+	void BudgetedTicker::Resize(std::size_t n)
+	{
+		lastTickAt.resize(n);
+		lastTickFrame.resize(n, frame);
+		if (cursor >= n)
+			cursor = 0;
+	}
+
+	const BudgetedTicker::Stats& BudgetedTicker::Tick(std::chrono::nanoseconds budget, const TickFunc& f)
+	{
+		++frame;
+		stats = Stats{};
+		auto n = Size();
+		if (n == 0)
+			return stats;
+
+		auto startAt = std::chrono::steady_clock::now();
+		auto now = startAt;
+
+		// Ticks one at least, and each one at most once.
+		do
+		{
+			auto i = cursor;
+			auto delta = lastTickAt[i] == Timepoint{} ? std::chrono::nanoseconds(0) : now - lastTickAt[i];
+			f(i, delta);
+			lastTickAt[i] = now;
+			lastTickFrame[i] = frame;
+			cursor = (cursor + 1) % n;
+			++stats.ticked;
+			now = std::chrono::steady_clock::now();
+		} while (stats.ticked < n && now - startAt < budget);
+
+		stats.deferred = n - stats.ticked;
+		// The one at the cursor is the most starved one, in a round-robin way.
+		if (stats.deferred > 0)
+			stats.maxStarvation = frame - lastTickFrame[cursor];
+		stats.elapsed = now - startAt;
+		return stats;
+	}
+
+	void LodTicker::Resize(std::size_t n)
+	{
+		for (auto i = n; i < entities.size(); i++)
+			Remove(i);
+		auto m = entities.size();
+		entities.resize(n);
+		for (auto i = m; i < n; i++)
+			Insert(i, 1);
+	}
+
+	void LodTicker::SetPeriod(std::size_t idx, unsigned int period)
+	{
+		if (period == 0)
+			throw std::runtime_error("bt: lod period must be positive");
+		if (entities[idx].period == period)
+			return;
+		Remove(idx);
+		Insert(idx, period);
+	}
+
+	void LodTicker::Insert(std::size_t idx, unsigned int period)
+	{
+		auto it = std::find_if(buckets.begin(), buckets.end(), [&](const auto& b) { return b.period == period; });
+		if (it == buckets.end())
+		{
+			// Keeps buckets ordered by period.
+			it = std::find_if(buckets.begin(), buckets.end(), [&](const auto& b) { return b.period > period; });
+			it = buckets.insert(it, { period, std::vector<std::vector<std::size_t>>(period) });
+		}
+		// Staggers into the least loaded phase.
+		auto& phases = it->phases;
+		auto  phase = std::min_element(phases.begin(), phases.end(),
+			 [](const auto& a, const auto& b) { return a.size() < b.size(); })
+			- phases.begin();
+		auto& e = entities[idx];
+		e.period = period;
+		e.phase = static_cast<unsigned int>(phase);
+		e.pos = phases[phase].size();
+		phases[phase].push_back(idx);
+	}
+
+	void LodTicker::Remove(std::size_t idx)
+	{
+		auto& e = entities[idx];
+		if (e.period == 0)
+			return;
+		auto it = std::find_if(buckets.begin(), buckets.end(), [&](const auto& b) { return b.period == e.period; });
+		// Swap-remove from the phase's list.
+		auto& list = it->phases[e.phase];
+		auto  last = list.back();
+		list[e.pos] = last;
+		entities[last].pos = e.pos;
+		list.pop_back();
+		e.period = 0;
+	}
+
+	std::size_t LodTicker::Tick(std::chrono::nanoseconds frameDelta, const TickFunc& f)
+	{
+		elapsed += frameDelta;
+		std::size_t k = 0;
+		for (auto& b : buckets)
+		{
+			for (auto i : b.phases[frame % b.period])
+			{
+				auto& e = entities[i];
+				f(i, e.ticked ? elapsed - e.lastTickAt : std::chrono::nanoseconds(0));
+				e.ticked = true;
+				e.lastTickAt = elapsed;
+				++k;
+			}
+		}
+		++frame;
+		return k;
+	}
+
+	void FixedTicker::Sleep(Timepoint deadline) { std::this_thread::sleep_until(deadline); }
+
+	void FixedTicker::Spin(Timepoint deadline)
+	{
+		while (std::chrono::steady_clock::now() < deadline)
+			;
+	}
+
+	FixedTicker::SleepStrategy FixedTicker::Hybrid(std::chrono::nanoseconds spinThreshold)
+	{
+		return [spinThreshold](Timepoint deadline) {
+			auto t = deadline - spinThreshold;
+			if (std::chrono::steady_clock::now() < t)
+				std::this_thread::sleep_until(t);
+			Spin(deadline);
+		};
+	}
+
+	FixedTicker::FixedTicker(std::chrono::nanoseconds interval, Policy policy, SleepStrategy sleep,
+		std::size_t maxCatchUp)
+		: interval(interval), policy(policy), sleep(sleep != nullptr ? sleep : Sleep), maxCatchUp(maxCatchUp)
+	{
+		if (interval <= std::chrono::nanoseconds(0))
+			throw std::runtime_error("bt: ticker interval must be positive");
+	}
+
+	void FixedTicker::Run(const TickFunc& f)
+	{
+		auto		startAt = std::chrono::steady_clock::now();
+		long long	k = 0; // index of next tick.
+		std::size_t catchUps = 0;
+
+		while (true)
+		{
+			auto s = state.load();
+			if (s == STOPPED)
+				return;
+			if (s == PAUSED)
+			{
+				state.wait(PAUSED);
+				// Restarts the schedule.
+				startAt = std::chrono::steady_clock::now();
+				k = 0;
+				continue;
+			}
+
+			auto deadline = startAt + k * interval;
+			auto now = std::chrono::steady_clock::now();
+			auto delta = interval;
+
+			if (now < deadline)
+			{
+				sleep(deadline);
+				if (state.load() != RUNNING)
+					continue;
+				now = std::chrono::steady_clock::now();
+			}
+
+			auto late = now - deadline;
+			if (late < interval)
+			{
+				// On schedule.
+				catchUps = 0;
+				stats.maxJitter = std::max(stats.maxJitter, std::chrono::nanoseconds(late));
+				stats.totalJitter += late;
+				++stats.numJitterSamples;
+			}
+			else if (policy == Policy::CatchUp && catchUps < maxCatchUp)
+				++catchUps;
+			else
+			{
+				// Skips the missed deadlines, the delta covers them.
+				long long missed = late / interval;
+				k += missed;
+				stats.skipped += missed;
+				delta += missed * interval;
+				catchUps = 0;
+			}
+
+			f(delta);
+			++stats.ticks;
+			++k;
+			if (std::chrono::steady_clock::now() > startAt + k * interval)
+				++stats.overruns;
+		}
+	}
+
+	void FixedTicker::Stop()
+	{
+		state.store(STOPPED);
+		state.notify_all();
+	}
+
+	void FixedTicker::Pause()
+	{
+		int expected = RUNNING;
+		state.compare_exchange_strong(expected, PAUSED);
+	}
+
+	void FixedTicker::Resume()
+	{
+		int expected = PAUSED;
+		if (state.compare_exchange_strong(expected, RUNNING))
+			state.notify_all();
+	}
+
+	//////////////////////////////////////////////////////////////
+	/// Trace Recorder
+	///////////////////////////////////////////////////////////////
+
+	static std::atomic<unsigned int> nextTraceThread = 0;
+
+	// Small index of current thread for trace records.
+	static thread_local unsigned int traceThread = nextTraceThread.fetch_add(1, std::memory_order_relaxed);
+
+	TraceRecorder::TraceRecorder(std::size_t capacity)
+		: buf(std::bit_ceil(std::max<std::size_t>(capacity, 1))), mask(buf.size() - 1)
+	{
+	}
+
+	void TraceRecorder::Record(ull seq, NodeId id, Status status, Timepoint startAt, Timepoint endAt)
+	{
+		auto  d = std::chrono::duration_cast<std::chrono::nanoseconds>(endAt - startAt).count();
+		auto& r = buf[next.fetch_add(1, std::memory_order_relaxed) & mask];
+		r.seq = seq;
+		r.startAt = std::chrono::duration_cast<std::chrono::nanoseconds>(startAt.time_since_epoch()).count();
+		r.duration = static_cast<unsigned int>(std::min<long long>(d, std::numeric_limits<unsigned int>::max()));
+		r.id = id;
+		r.status = status;
+		r.thread = traceThread;
+	}
+
+	std::size_t TraceRecorder::Size() const
+	{
+		return static_cast<std::size_t>(std::min<ull>(next.load(std::memory_order_relaxed), buf.size()));
+	}
+
+	std::vector<TraceRecord> TraceRecorder::Records() const
+	{
+		std::vector<TraceRecord> records;
+		records.reserve(Size());
+		Visit([&](const TraceRecord& r) { records.push_back(r); });
+		return records;
+	}
+
+	ull TraceRecorder::Visit(const std::function<void(const TraceRecord&)>& f, ull since) const
+	{
+		auto n = next.load(std::memory_order_acquire);
+		auto start = std::max<ull>(since, n - std::min<ull>(n, buf.size()));
+		for (auto i = start; i < n; i++)
+			f(buf[i & mask]);
+		return n;
+	}
+
+	void TraceRecorder::Dump(std::FILE* f) const
+	{
+		for (const auto& r : Records())
+			fprintf(f, "seq=%llu id=%u status=%c start=%lld dur=%uns thread=%u\n", r.seq, r.id, StatusRepr(r.status),
+				r.startAt, r.duration, r.thread);
+	}
+
+	// Escapes given string for a JSON string (also good for a DOT string), writes chars by function put.
+	template <typename Put>
+	static void EscapeJSONString(std::string_view s, Put put)
+	{
+		static const char* hex = "0123456789abcdef";
+		for (unsigned char c : s)
+		{
+			if (c == '"' || c == '\\')
+			{
+				put('\\');
+				put(c);
+			}
+			else if (c < 0x20)
+			{
+				for (char x : { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] })
+					put(x);
+			}
+			else
+				put(c);
+		}
+	}
+
+	// Writes given string as a JSON string.
+	static void WriteJSONString(std::FILE* f, std::string_view s)
+	{
+		fputc('"', f);
+		EscapeJSONString(s, [f](char c) { fputc(c, f); });
+		fputc('"', f);
+	}
+
+	// Appends given string as a JSON string.
+	static void AppendJSONString(std::string& out, std::string_view s)
+	{
+		out += '"';
+		EscapeJSONString(s, [&out](char c) { out += c; });
+		out += '"';
+	}
+
+	ChromeTraceWriter::ChromeTraceWriter(std::FILE* f)
+		: f(f)
+	{
+		if (f == nullptr)
+			throw std::runtime_error("bt: null trace file");
+		fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	}
+
+	void ChromeTraceWriter::WriteEventPrefix()
+	{
+		if (!first)
+			fputc(',', f);
+		fputc('\n', f);
+		first = false;
+	}
+
+	void ChromeTraceWriter::SetEntityName(ull entity, std::string_view name)
+	{
+		WriteEventPrefix();
+		fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%llu,\"args\":{\"name\":", entity);
+		WriteJSONString(f, name);
+		fprintf(f, "}}");
+	}
+
+	const std::vector<std::string>& ChromeTraceWriter::NodeNames(RootNode& root)
+	{
+		auto& v = names[&root];
+		if (v.size() != static_cast<std::size_t>(root.NumNodes()))
+		{
+			v.assign(root.NumNodes(), "");
+			TraversalCallback pre = [&](Node& node, Ptr<Node>& ptr) { v[node.Id() - 1] = node.Name(); };
+			root.Traverse(pre, NullTraversalCallback, NullNodePtr);
+		}
+		return v;
+	}
+
+	void ChromeTraceWriter::Write(RootNode& root, const TraceRecord& r, ull entity)
+	{
+		auto& v = NodeNames(root);
+
+		WriteEventPrefix();
+		fprintf(f, "{\"name\":");
+		WriteJSONString(f, r.id >= 1 && r.id <= v.size() ? v[r.id - 1] : "?");
+		// Timestamps in microseconds.
+		fprintf(f,
+			",\"cat\":\"bt\",\"ph\":\"X\",\"ts\":%lld.%03lld,\"dur\":%u.%03u,\"pid\":%llu,\"tid\":%u,"
+			"\"args\":{\"id\":%u,\"seq\":%llu,\"status\":\"%s\"}}",
+			r.startAt / 1000, r.startAt % 1000, r.duration / 1000, r.duration % 1000, entity, r.thread, r.id, r.seq,
+			StatusName(r.status));
+	}
+
+	ull ChromeTraceWriter::Write(RootNode& root, const TraceRecorder& recorder, ull entity, ull since)
+	{
+		return recorder.Visit([&](const TraceRecord& r) { Write(root, r, entity); }, since);
+	}
+
+	void ChromeTraceWriter::Close()
+	{
+		if (closed)
+			return;
+		closed = true;
+		fprintf(f, "\n]}\n");
+		fflush(f);
+	}
+
+	//////////////////////////////////////////////////////////////
+	/// Visualizer
+	///////////////////////////////////////////////////////////////
+
+	Visualizer::Visualizer(RootNode& root, std::FILE* out)
+		: root(root), out(out)
+	{
+		int				  depth = -1;
+		std::vector<std::size_t> stack;
+		TraversalCallback pre = [&](Node& node, Ptr<Node>& ptr) {
+			stack.push_back(entries.size());
+			entries.push_back({ &node, ++depth, 0 });
+		};
+		TraversalCallback post = [&](Node& node, Ptr<Node>& ptr) {
+			entries[stack.back()].end = entries.size();
+			stack.pop_back();
+			--depth;
+		};
+		root.Traverse(pre, post, NullNodePtr);
+		lines.resize(entries.size());
+		next.resize(entries.size());
+		colors.resize(entries.size());
+		nextColors.resize(entries.size());
+	}
+
+	void Visualizer::Render(ull seq)
+	{
+		auto blob = root.GetTreeBlob();
+
+		// Renders into the next buffers.
+		std::size_t k = 0;
+		for (std::size_t i = 0; i < entries.size();)
+		{
+			auto& [node, depth, end] = entries[i];
+			auto  b = blob->Peek(node->Id());
+			bool  active = b != nullptr && b->lastSeq == seq;
+
+			auto& line = next[k];
+			line.clear();
+			if (depth > 0)
+				line += " |";
+			for (int j = 1; j < depth; j++)
+				line += "---|";
+			if (depth > 0)
+				line += "- ";
+			line += node->Name();
+			line += '(';
+			line += StatusRepr(b != nullptr ? b->lastStatus : Status::UNDEFINED);
+			line += ')';
+			nextColors[k] = active;
+			++k;
+
+			if (collapseInactive && !active && end > i + 1)
+			{
+				// Collapses the subtree.
+				char tail[32];
+				snprintf(tail, sizeof(tail), " [+%zu]", end - i - 1);
+				line += tail;
+				i = end;
+			}
+			else
+				++i;
+		}
+
+		// Writes the changed lines.
+		buf.clear();
+		if (dirty)
+			buf += "\x1B[2J";
+		numChangedLines = 0;
+		for (std::size_t j = 0; j < k; j++)
+		{
+			if (!dirty && j < numLines && next[j] == lines[j] && nextColors[j] == colors[j])
+				continue;
+			++numChangedLines;
+			char pos[32];
+			// Moves the cursor to the line's head.
+			snprintf(pos, sizeof(pos), "\x1B[%zu;1H", j + 1);
+			buf += pos;
+			if (nextColors[j])
+				buf += "\033[32m";
+			buf += next[j];
+			if (nextColors[j])
+				buf += "\033[0m";
+			// Clears the rest of the line.
+			buf += "\x1B[K";
+		}
+		if (k < numLines)
+		{
+			// Clears the lines left by the last frame.
+			char pos[32];
+			snprintf(pos, sizeof(pos), "\x1B[%zu;1H\x1B[J", k + 1);
+			buf += pos;
+		}
+		if (!buf.empty())
+		{
+			fwrite(buf.data(), 1, buf.size(), out);
+			fflush(out);
+		}
+
+		lines.swap(next);
+		colors.swap(nextColors);
+		numLines = k;
+		dirty = false;
+	}
+
+	//////////////////////////////////////////////////////////////
+	/// Tree State Dumper
+	///////////////////////////////////////////////////////////////
+
+	void TreeStateDumper::DumpJSON(RootNode& root, std::string& out)
+	{
+		auto			  blob = root.GetTreeBlob();
+		std::vector<bool> hasChild; // stack of whether a node has dumped children.
+		char			  buf[128];
+
+		TraversalCallback pre = [&](Node& node, Ptr<Node>& ptr) {
+			if (!hasChild.empty())
+			{
+				if (hasChild.back())
+					out += ',';
+				hasChild.back() = true;
+			}
+			hasChild.push_back(false);
+
+			// Stable id is a string, since it may exceed the JSON's safe integer.
+			snprintf(buf, sizeof(buf), "{\"id\":%u,\"stableId\":\"%llu\",\"name\":", node.Id(), node.StableId());
+			out += buf;
+			AppendJSONString(out, node.Name());
+
+			auto b = blob->Peek(node.Id());
+			if (b != nullptr)
+			{
+				snprintf(buf, sizeof(buf), ",\"lastStatus\":\"%s\",\"lastSeq\":%llu,\"running\":%s",
+					StatusName(b->lastStatus), b->lastSeq, b->running ? "true" : "false");
+				out += buf;
+				fields.clear();
+				if (hook != nullptr)
+					hook(node, *b, fields);
+				if (!fields.empty())
+				{
+					out += ",\"fields\":{";
+					for (std::size_t i = 0; i < fields.size(); i++)
+					{
+						if (i > 0)
+							out += ',';
+						AppendJSONString(out, fields[i].first);
+						out += ':';
+						AppendJSONString(out, fields[i].second);
+					}
+					out += '}';
+				}
+			}
+			out += ",\"children\":[";
+		};
+		TraversalCallback post = [&](Node& node, Ptr<Node>& ptr) {
+			hasChild.pop_back();
+			out += "]}";
+		};
+		root.Traverse(pre, post, NullNodePtr);
+	}
+
+	void TreeStateDumper::DumpDOT(RootNode& root, std::string& out)
+	{
+		auto				blob = root.GetTreeBlob();
+		std::vector<NodeId> stack;
+		char				buf[128];
+
+		out += "digraph bt {\n  node [shape=box, style=filled];\n";
+		TraversalCallback pre = [&](Node& node, Ptr<Node>& ptr) {
+			auto		b = blob->Peek(node.Id());
+			auto		status = b != nullptr ? b->lastStatus : Status::UNDEFINED;
+			const char* colors[] = { "lightgray", "gold", "palegreen", "salmon" };
+
+			snprintf(buf, sizeof(buf), "  n%u [label=\"", node.Id());
+			out += buf;
+			EscapeJSONString(node.Name(), [&out](char c) { out += c; });
+			snprintf(buf, sizeof(buf), "\\n#%u %s", node.Id(), StatusName(status));
+			out += buf;
+			if (b != nullptr)
+			{
+				snprintf(buf, sizeof(buf), "\\nseq=%llu%s", b->lastSeq, b->running ? " running" : "");
+				out += buf;
+				fields.clear();
+				if (hook != nullptr)
+					hook(node, *b, fields);
+				for (auto& [k, v] : fields)
+				{
+					out += "\\n";
+					EscapeJSONString(k, [&out](char c) { out += c; });
+					out += '=';
+					EscapeJSONString(v, [&out](char c) { out += c; });
+				}
+			}
+			snprintf(buf, sizeof(buf), "\", fillcolor=%s];\n", colors[static_cast<int>(status)]);
+			out += buf;
+			if (!stack.empty())
+			{
+				snprintf(buf, sizeof(buf), "  n%u -> n%u;\n", stack.back(), node.Id());
+				out += buf;
+			}
+			stack.push_back(node.Id());
+		};
+		TraversalCallback post = [&](Node& node, Ptr<Node>& ptr) { stack.pop_back(); };
+		root.Traverse(pre, post, NullNodePtr);
+		out += "}\n";
+	}
+
 } // namespace bt
@@ -6,17 +6,27 @@
 #define HIT9_BT_H
 
 #include <any>
-#include <chrono>  // for milliseconds, steady_clock
-#include <cstring> // for memset
+#include <atomic> // for atomic
+#include <chrono>	 // for milliseconds, steady_clock
+#include <coroutine> // for coroutine_handle
+#include <cstddef>	 // for max_align_t
+#include <cstdint>	 // for uint64_t
+#include <cstdio>	 // for FILE
+#include <cstring>	 // for memset
+#include <exception> // for exception_ptr
 #include <functional>
 #include <memory> // for unique_ptr
+#include <new>	  // for launder
 #include <queue>  // for priority_queue
+#include <span>	  // for span
 #include <stack>
 #include <stdexcept> // for runtime_error
 #include <string>
 #include <string_view>
 #include <type_traits> // for is_base_of_v
-#include <utility>	   // for pair
+#include <typeinfo>	   // for type_info
+#include <unordered_map>
+#include <utility> // for pair
 #include <vector>
 
 namespace bt
@@ -34,6 +44,13 @@ namespace bt
 	// Node instance's id type.
 	using NodeId = unsigned int;
 
+	// Node's stable id type, which is independent of the build order.
+	using StableNodeId = unsigned long long;
+
+	using Timepoint = std::chrono::time_point<std::chrono::steady_clock>;
+
+	class Blackboard; // forward declaration.
+
 	// Tick/Update's Context.
 	struct Context
 	{
@@ -48,6 +65,11 @@ namespace bt
 		//   bt::Context ctx{.data = std::make_shared<Blackboard>()};
 		std::any data;
 
+		// Typed blackboard of current entity, optional.
+		// Code example::
+		//   ctx.blackboard->Get(hpKey) -= 10;
+		Blackboard* blackboard = nullptr;
+
 		// Constructors.
 		Context() = default;
 
@@ -55,6 +77,130 @@ namespace bt
 			: data(data), seq(0) {}
 	};
 
+	////////////////////////////
+	/// Blackboard
+	////////////////////////////
+
+	// BlackboardKey is a typed key to a slot of blackboards, resolved by a BlackboardLayout.
+	template <typename T>
+	struct BlackboardKey
+	{
+		// Dense index of the slot in the layout.
+		std::size_t slot = 0;
+		// Byte offset of the slot in blackboards' storage.
+		std::size_t offset = 0;
+	};
+
+	// BlackboardLayout maps named keys to typed slots of blackboards' storage, shared by entities' blackboards.
+	// Keys are resolved once, e.g. on building trees, then accessing a slot is a single indexed load, without
+	// RTTI or reference counting.
+	// A layout is sealed once a blackboard is created on it, no more keys can be added then.
+	// Code example::
+	//   bt::BlackboardLayout layout;
+	//   auto hp = layout.Key<int>("hp");
+	//   auto target = layout.Key<std::string>("target");
+	//   root.Action<Attack>(hp); // passes keys to nodes.
+	//   // Per entity.
+	//   bt::Blackboard bb(layout);
+	//   ctx.blackboard = &bb;
+	class BlackboardLayout
+	{
+	public:
+		// Returns the key of given name, adds a default constructed slot for it if not exist.
+		// Throws if the name exists with another type, or the layout is sealed.
+		template <typename T>
+		BlackboardKey<T> Key(std::string_view name);
+
+		// Returns the number of slots.
+		std::size_t NumSlots() const { return slots.size(); }
+
+		// Returns the size of blackboards' storage.
+		std::size_t Size() const { return size; }
+
+		// Returns true if any blackboard is created on this layout.
+		bool Sealed() const { return sealed; }
+
+	private:
+		struct Slot
+		{
+			std::string			  name;
+			const std::type_info* type;
+			std::size_t			  offset;
+			void (*construct)(void*);
+			void (*destroy)(void*); // nullptr for trivially destructible types.
+		};
+
+		// Returns the slot index and offset.
+		std::pair<std::size_t, std::size_t> AddSlot(std::string_view name, const std::type_info& type,
+			std::size_t size, std::size_t align, void (*construct)(void*), void (*destroy)(void*));
+
+		std::vector<Slot> slots;
+		std::size_t		  size = 0;
+		std::size_t		  align = alignof(std::max_align_t);
+		bool			  sealed = false;
+
+		friend class Blackboard; // for access to slots and sealed.
+	};
+
+	// Blackboard is an entity's typed storage, a continuous buffer laid out by a BlackboardLayout, the layout must
+	// outlive it. All slots are default constructed on creation.
+	// Code example::
+	//   bt::Status Update(const bt::Context& ctx) override {
+	//     auto& hp = ctx.blackboard->Get(hpKey);
+	//     ...
+	//   }
+	class Blackboard
+	{
+	public:
+		explicit Blackboard(BlackboardLayout& layout);
+		~Blackboard();
+
+		Blackboard(const Blackboard&) = delete;
+		Blackboard& operator=(const Blackboard&) = delete;
+		Blackboard(Blackboard&& o) noexcept
+			: layout(o.layout), data(o.data), versions(std::move(o.versions)), clock(o.clock) { o.data = nullptr; }
+
+		// Returns a reference to the value of given key.
+		template <typename T>
+		T& Get(BlackboardKey<T> key) { return *std::launder(reinterpret_cast<T*>(data + key.offset)); }
+
+		template <typename T>
+		const T& Get(BlackboardKey<T> key) const { return *std::launder(reinterpret_cast<const T*>(data + key.offset)); }
+
+		// Sets the value of given key, and marks the slot changed.
+		template <typename T>
+		void Set(BlackboardKey<T> key, T value)
+		{
+			Get(key) = std::move(value);
+			Touch(key.slot);
+		}
+
+		// Returns a reference to the value of given key for writing, and marks the slot changed.
+		// Note that writes via Get() are not tracked.
+		template <typename T>
+		T& Mutable(BlackboardKey<T> key)
+		{
+			Touch(key.slot);
+			return Get(key);
+		}
+
+		// Marks given slot changed.
+		void Touch(std::size_t slot) { versions[slot] = ++clock; }
+
+		// Returns the version of given slot, that is the clock of its last change, 0 for never changed.
+		ull Version(std::size_t slot) const { return versions[slot]; }
+
+		// Returns the clock of this blackboard, which increases on every tracked change.
+		ull Clock() const { return clock; }
+
+	private:
+		const BlackboardLayout* layout;
+		unsigned char*			data = nullptr;
+		// Version of each slot.
+		std::vector<ull> versions;
+		ull				 clock = 0;
+	};
+
 	////////////////////////////
 	/// TreeBlob
 	////////////////////////////
@@ -89,7 +235,34 @@ namespace bt
 		template <TNodeBlob B>
 		B* Make(const NodeId id, const std::function<void(NodeBlob*)>& cb, const std::size_t cap = 0);
 
+		// Returns a pointer to the NodeBlob of the node with given id, nullptr if not allocated.
+		// It never allocates, for inspection purpose e.g. visualization.
+		NodeBlob* Peek(const NodeId id);
+
+		// Resets all node blobs to the initial state, e.g. for a respawned entity, keeping the memory.
+		// Node blobs are constructed again in place on their next access, without allocations.
+		virtual void Reset() = 0;
+
+		// Returns the bytes of memory held by this tree blob, including the tree blob object itself.
+		virtual std::size_t NumReservedBytes() const = 0;
+
+		// Returns the number of heap allocations held by this tree blob.
+		virtual std::size_t NumAllocations() const = 0;
+
+		// Alignment of node blobs' memory, node blobs can't be over-aligned.
+		static constexpr std::size_t BlobAlign = alignof(std::max_align_t);
+
 	protected:
+		// BlobOps are the operations of a non-trivially copyable node blob type, registered on its construction.
+		// Trivially copyable blobs have no ops, they are relocated by bytes copying and never destroyed.
+		struct BlobOps
+		{
+			// Runs the destructor of a node blob in place.
+			void (*destroy)(void* p);
+			// Move constructs the node blob at dst from the one at src, and then destroys the one at src.
+			void (*relocate)(void* dst, void* src);
+		};
+
 		// Allocates memory for given index, returns the pointer to the node blob.
 		virtual void* Allocate(const std::size_t idx, const std::size_t size) = 0;
 
@@ -103,47 +276,354 @@ namespace bt
 		// Pre-reserve enough capacity if need.
 		virtual void Reserve(const std::size_t cap) {}
 
+		// RemapPlan moves blobs to new indexes, it's made once by TreeBlobMigration for all entities' tree blobs.
+		struct RemapPlan
+		{
+			// src[i] is the index of the blob to move to index i, -1 for none.
+			std::vector<int> src;
+			// Indexes of the blobs not moved, they are dropped first.
+			std::vector<int> drops;
+			// Moves of blobs in place, as pairs of (to, from), in order. The destination of a move is always
+			// vacated before. Index -1 stands for a scratch cell, to break the cycles of moves.
+			std::vector<std::pair<int, int>> moves;
+		};
+
+		// Moves blobs to new indexes by given plan: the blob at index src[i] goes to index i.
+		// Blobs not moved are dropped.
+		virtual void Remap(const RemapPlan& plan) = 0;
+
+		// Registers the ops of the blob just constructed at given index, for non-trivially copyable blobs only.
+		// The blob should be destroyed with them once dropped, i.e. on Reset, Remap and destruction, and be
+		// relocated with them once moved to another memory, i.e. on Remap and moving of the tree blob.
+		virtual void SetOps(const std::size_t idx, const BlobOps* ops) = 0;
+
+		// A word of the existence bitmap of FixedTreeBlob and SizedTreeBlob, bit i for index i.
+		// Words are atomic, since blobs of different nodes sharing a word may be allocated concurrently, e.g. by
+		// ConcurrentParallelNode. A bit is set with release order after the blob is zeroed.
+		using BitmapWord = std::atomic<std::uint64_t>;
+
+		// Relocates a node blob of given size and ops (nullptr for trivially copyable ones) from src to dst.
+		static void Relocate(void* dst, void* src, const std::size_t size, const BlobOps* ops)
+		{
+			if (ops != nullptr)
+				ops->relocate(dst, src);
+			else
+				memcpy(dst, src, size);
+		}
+
+		// Remaps the cells of a FixedTreeBlob or SizedTreeBlob in place by given plan, i.e. n cells of given stride
+		// starting at buf, with the existence bitmap bits and the blob ops array. The scratch is a spare cell.
+		static void RemapCells(const RemapPlan& plan, unsigned char* buf, const std::size_t stride, const std::size_t n,
+			BitmapWord* bits, const BlobOps** ops, unsigned char* scratch);
+
 	private:
 		std::pair<void*, bool> Make(const NodeId id, size_t size, const std::size_t cap = 0);
+
+		// friend with TreeBlobMigration to access Remap.
+		friend class TreeBlobMigration;
 	};
 
 	// FixedTreeBlob is just a continuous buffer, implements ITreeBlob.
+	// Node blobs are stored in cells aligned to BlobAlign, their existence flags are stored in a separate bitmap of
+	// atomic words.
 	template <std::size_t NumNodes, std::size_t MaxSizeNodeBlob>
 	class FixedTreeBlob final : public ITreeBlob
 	{
 	public:
+		// Size of a cell, MaxSizeNodeBlob rounded up to BlobAlign.
+		static constexpr std::size_t Stride =
+			MaxSizeNodeBlob == 0 ? BlobAlign : (MaxSizeNodeBlob + BlobAlign - 1) / BlobAlign * BlobAlign;
+
 		FixedTreeBlob();
+		~FixedTreeBlob() override { Destroy(); }
+
+		// Blobs are relocated on moving, copying is disabled to avoid destroying a blob twice.
+		FixedTreeBlob(const FixedTreeBlob&) = delete;
+		FixedTreeBlob& operator=(const FixedTreeBlob&) = delete;
+		FixedTreeBlob(FixedTreeBlob&& o) noexcept;
+		FixedTreeBlob& operator=(FixedTreeBlob&& o) noexcept;
+
+		void Reset() override;
+
+		std::size_t NumReservedBytes() const override { return sizeof(*this); }
+		std::size_t NumAllocations() const override { return 0; }
 
 	protected:
 		void* Allocate(const std::size_t idx, const std::size_t size) override;
 		bool  Exist(const std::size_t idx) override;
 		void* Get(const std::size_t idx) override;
+		void  Remap(const RemapPlan& plan) override;
+		void  SetOps(const std::size_t idx, const BlobOps* o) override { ops[idx] = o; }
 
 	private:
-		unsigned char buf[NumNodes][MaxSizeNodeBlob + 1];
+		static constexpr std::size_t NumWords = (NumNodes + 63) / 64;
+
+		alignas(BlobAlign) unsigned char buf[NumNodes][Stride];
+		BitmapWord						 bits[NumWords];		 // existence bitmap, bit idx for index idx.
+		const BlobOps*					 ops[NumNodes];		 // index => blob ops, nullptr for trivial blobs.
+
+		// Destroys all non-trivial blobs.
+		void Destroy();
+		// Moves the blobs from o, which is cleared.
+		void MoveFrom(FixedTreeBlob& o);
+	};
+
+	// BlobPool is a process-wide pool of memory blocks for node blobs, in size classes of 16 bytes, up to MaxSize.
+	// Freed blocks go to a per-thread cache first, and move between the thread caches and the shared free lists
+	// in batches, so allocations are mostly lock free. Memory is never returned to the system, but reused by
+	// blobs of the same size class, which suits entities spawning and dying all the time.
+	// Larger blocks go to the global allocator directly.
+	// Code example::
+	//   bt::DynamicTreeBlob blob(true); // allocates from the pool.
+	class BlobPool
+	{
+	public:
+		static constexpr std::size_t MaxSize = 1024;
+
+		// Allocates a block of given size, the memory is aligned to 16 bytes.
+		static void* Allocate(std::size_t size);
+
+		// Deallocates a block allocated by Allocate() with the same size, from any thread.
+		static void Deallocate(void* p, std::size_t size);
+
+		// Returns the bytes of memory reserved by the pool.
+		static std::size_t NumReservedBytes();
 	};
 
-	// DynamicTreeBlob contains dynamic allocated unique pointers, implements ITreeBlob.
+	// DynamicTreeBlob contains dynamic allocated node blobs, implements ITreeBlob.
+	// Node blobs are allocated from the global allocator, or from the BlobPool if pooled.
 	class DynamicTreeBlob final : public ITreeBlob
 	{
 	public:
-		DynamicTreeBlob() {}
+		explicit DynamicTreeBlob(bool pooled = false)
+			: pooled(pooled) {}
+		~DynamicTreeBlob() override { Release(); }
+
+		DynamicTreeBlob(DynamicTreeBlob&& o) noexcept;
+		DynamicTreeBlob& operator=(DynamicTreeBlob&& o) noexcept;
+
+		// Releases all node blobs at once, e.g. when the entity dies.
+		// The blob is empty afterwards, and can be bound again.
+		void Release();
+
+		void Reset() override;
+
+		// Pooled blocks are counted by their size classes, but not as heap allocations.
+		std::size_t NumReservedBytes() const override;
+		std::size_t NumAllocations() const override;
 
 	protected:
 		void* Allocate(const std::size_t idx, const std::size_t size) override;
 		bool  Exist(const std::size_t idx) override;
 		void* Get(const std::size_t idx) override;
 		void  Reserve(const std::size_t cap) override;
+		void  Remap(const RemapPlan& plan) override;
+		void  SetOps(const std::size_t idx, const BlobOps* ops) override { m[idx].ops = ops; }
 
 	private:
-		std::vector<std::unique_ptr<unsigned char[]>> m; // index => blob pointer.
-		std::vector<bool>							  e; // index => exist, dynamic
+		struct Slot
+		{
+			unsigned char* p = nullptr;		  // nullptr for not allocated.
+			std::size_t	   size = 0;
+			bool		   exist = false;	  // is a blob constructed on the memory?
+			const BlobOps* ops = nullptr;	  // nullptr for trivial blobs.
+		};
+
+		bool			  pooled;
+		std::vector<Slot> m; // index => blob slot.
+
+		// Destroys the blob of given slot if constructed, keeping the memory.
+		void Destroy(Slot& slot);
+		void Free(Slot& slot);
+	};
+
+	// BlobArena is a continuous region of memory for the buffers of many entities' SizedTreeBlobs, allocated once.
+	// For worlds of lots of entities, it can be backed by transparent huge pages to reduce TLB misses, and be locked
+	// in RAM. On Linux, it's an anonymous mmap aligned to 2MB, advised with MADV_HUGEPAGE if hugePages, and
+	// mlock-ed if lock. Both are best efforts, see HugePages() and Locked(). On other platforms, it's allocated
+	// from the global allocator.
+	// Buffers are never freed individually, the arena should outlive the tree blobs allocated from it.
+	// Code example::
+	//   bt::BlobArena arena(n * bt::SizedTreeBlob::NumBufferBytes(root));
+	//   for (auto& e : entities) e.blob = std::make_unique<bt::SizedTreeBlob>(root, &arena);
+	class BlobArena
+	{
+	public:
+		explicit BlobArena(std::size_t capacity, bool hugePages = true, bool lock = false);
+		~BlobArena();
+
+		BlobArena(const BlobArena&) = delete;
+		BlobArena& operator=(const BlobArena&) = delete;
+
+		// Allocates a block of given size, aligned to ITreeBlob::BlobAlign. Thread safe.
+		// Throws if the capacity is not enough.
+		void* Allocate(std::size_t size);
+
+		// Returns the bytes of the region.
+		std::size_t Capacity() const { return capacity; }
+
+		// Returns the bytes allocated.
+		std::size_t NumAllocatedBytes() const { return used.load(std::memory_order_relaxed); }
+
+		// Returns true if the region is advised to be backed by transparent huge pages.
+		bool HugePages() const { return hugePages; }
+
+		// Returns true if the region is locked in RAM.
+		bool Locked() const { return locked; }
+
+	private:
+		unsigned char*			 p = nullptr;
+		std::size_t				 capacity;
+		std::size_t				 mapped = 0; // bytes mapped, 0 if allocated from the global allocator.
+		std::atomic<std::size_t> used = 0;
+		bool					 hugePages = false;
+		bool					 locked = false;
+	};
+
+	class RootNode; // forward declaration.
+
+	// SizedTreeBlob is a FixedTreeBlob sized at runtime, implements ITreeBlob.
+	// Its single continuous buffer is allocated once on construction, exactly fitting a built tree, there's no
+	// allocations afterwards. The buffer is allocated from given BlobArena if not nullptr.
+	// Code example::
+	//   bt::SizedTreeBlob blob(root); // or blob(root.NumNodes(), root.MaxSizeNodeBlob())
+	class SizedTreeBlob final : public ITreeBlob
+	{
+	public:
+		// Sizes for the given built tree.
+		explicit SizedTreeBlob(const RootNode& root, BlobArena* arena = nullptr);
+		SizedTreeBlob(std::size_t numNodes, std::size_t maxSizeNodeBlob, BlobArena* arena = nullptr);
+		~SizedTreeBlob() override;
+
+		// Blobs are relocated on moving, copying is disabled to avoid destroying a blob twice.
+		SizedTreeBlob(const SizedTreeBlob&) = delete;
+		SizedTreeBlob& operator=(const SizedTreeBlob&) = delete;
+		SizedTreeBlob(SizedTreeBlob&& o) noexcept;
+		SizedTreeBlob& operator=(SizedTreeBlob&& o) noexcept;
+
+		void Reset() override;
+
+		// Buffers from an arena are not counted as heap allocations.
+		std::size_t NumReservedBytes() const override { return sizeof(*this) + NumBufferBytes(); }
+		std::size_t NumAllocations() const override { return buf != nullptr && arena == nullptr ? 1 : 0; }
+
+		// Returns the bytes of the buffer of a SizedTreeBlob for given tree, e.g. to size a BlobArena.
+		static std::size_t NumBufferBytes(const RootNode& root);
+
+		// Returns the number of nodes to store.
+		std::size_t NumNodes() const { return numNodes; }
+
+		// Returns the max size of node blobs to store.
+		std::size_t MaxSizeNodeBlob() const { return maxSizeNodeBlob; }
+
+	protected:
+		void* Allocate(const std::size_t idx, const std::size_t size) override;
+		bool  Exist(const std::size_t idx) override;
+		void* Get(const std::size_t idx) override;
+		void  Remap(const RemapPlan& plan) override;
+		void  SetOps(const std::size_t idx, const BlobOps* ops) override { Ops()[idx] = ops; }
+
+	private:
+		std::size_t numNodes = 0;
+		std::size_t maxSizeNodeBlob = 0;
+		// The cells of node blobs in the same layout as FixedTreeBlob and a scratch cell for Remap, followed by the
+		// existence bitmap and the blob ops array.
+		unsigned char* buf = nullptr;
+		// The arena the buffer is allocated from, nullptr for the global allocator.
+		BlobArena* arena = nullptr;
+
+		std::size_t	   Stride() const { return (maxSizeNodeBlob + BlobAlign - 1) / BlobAlign * BlobAlign; }
+		std::size_t	   NumWords() const { return (numNodes + 63) / 64; }
+		std::size_t	   NumBufferBytes() const { return NumBufferBytes(numNodes, maxSizeNodeBlob); }
+		static std::size_t NumBufferBytes(std::size_t numNodes, std::size_t maxSizeNodeBlob);
+		unsigned char* Cell(std::size_t idx) const { return buf + idx * Stride(); }
+		BitmapWord*	   Bits() const { return reinterpret_cast<BitmapWord*>(Cell(numNodes + 1)); }
+		const BlobOps** Ops() const { return reinterpret_cast<const BlobOps**>(Bits() + NumWords()); }
+
+		// Destroys all non-trivial blobs.
+		void Destroy();
+	};
+
+	////////////////////////////
+	/// Batch
+	////////////////////////////
+
+	// BatchMask is a bitset over a batch of entities, bit i for the i-th entity of the batch.
+	// The underlying 64-bit words are exposed for SIMD implementations of ConditionNode::CheckBatch().
+	class BatchMask
+	{
+	public:
+		// Resizes to n bits, all cleared.
+		void Reset(std::size_t n)
+		{
+			size = n;
+			words.assign((n + 63) / 64, 0);
+		}
+
+		// Clears the bits in range [first, last).
+		void Clear(std::size_t first, std::size_t last);
+
+		// Returns the number of bits.
+		std::size_t Size() const { return size; }
+
+		// Returns true if bit i is set.
+		bool Test(std::size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+
+		// Sets bit i.
+		void Set(std::size_t i) { words[i >> 6] |= std::uint64_t(1) << (i & 63); }
+
+		// Returns the underlying words, bit i is at bit (i % 64) of word (i / 64).
+		std::uint64_t* Words() { return words.data(); }
+
+		// Returns the number of the underlying words.
+		std::size_t NumWords() const { return words.size(); }
+
+	private:
+		std::size_t				   size = 0;
+		std::vector<std::uint64_t> words;
+	};
+
+	// Batch is a population of entities ticked together on a tree, see RootNode::TickBatch().
+	// The i-th entity is ticked with contexts[i] on tree blob blobs[i].
+	// Nodes are ticked for the entities by their indices in the batch, always in ascending order.
+	struct Batch
+	{
+		std::span<const Context>	contexts;
+		std::span<ITreeBlob* const> blobs;
+		// Status register of the entities, a node's batch tick writes its status of the i-th entity to statuses[i].
+		std::span<Status> statuses;
+		// The root of the ticking tree.
+		RootNode* root = nullptr;
+		// Internal stack of the node blobs of ticking entities.
+		std::vector<NodeBlob*>* nodeBlobs = nullptr;
+
+		// Binds the tree blob of the i-th entity to the root.
+		void Bind(std::size_t i);
 	};
 
 	////////////////////////////
 	/// Node
 	////////////////////////////
 
+	class TraceRecorder; // forward declaration.
+
+	// MemoryReport is the memory usage of a tree and an entity's tree blob, see RootNode::ReportMemory().
+	struct MemoryReport
+	{
+		// Shared by all entities.
+		int			numNodes = 0;
+		std::size_t nodeBytes = 0;	   // sizes of the node objects, i.e. RootNode::TreeSize().
+		std::size_t nodeHeapBytes = 0; // heap memory owned by the nodes, e.g. names and children vectors.
+		// Per entity, measured on the given tree blob.
+		std::size_t blobUsedBytes = 0;	   // sizes of the node blobs constructed.
+		std::size_t blobReservedBytes = 0; // memory held by the tree blob, including itself.
+		std::size_t blobPaddingBytes = 0;  // reserved but not used, e.g. unused cells of a FixedTreeBlob.
+		std::size_t blobHeapBytes = 0;	   // heap memory owned by the node blobs, e.g. stateful composites' flags.
+		std::size_t blobAllocations = 0;   // heap allocations held by the tree blob and its node blobs.
+		// Per entity, sizes of all nodes' blobs, i.e. the used bytes once every node is ticked.
+		std::size_t blobFullBytes = 0;
+	};
+
 	// RootNode Interface.
 	class IRootNode
 	{
@@ -153,9 +633,37 @@ namespace bt
 
 		// Returns the total number of nodes built on this tree.
 		virtual int NumNodes() const = 0;
+
+		// Returns the current binding TraceRecorder's pointer, nullptr for none.
+		virtual TraceRecorder* GetTraceRecorder(void) const = 0;
 	};
 
 	class Node; // forward declaration.
+	class FixedTicker; // forward declaration.
+
+	// ProfileSlot holds the index of a node's profiling counters, see Profiler.
+	// It's move-only, and releases the slot for reuse on destruction.
+	struct ProfileSlot
+	{
+		unsigned int index = 0; // 0 for none.
+
+		ProfileSlot() = default;
+		ProfileSlot(ProfileSlot&& o) noexcept
+			: index(std::exchange(o.index, 0)) {}
+		ProfileSlot& operator=(ProfileSlot&& o) noexcept
+		{
+			if (this != &o)
+			{
+				Release();
+				index = std::exchange(o.index, 0);
+			}
+			return *this;
+		}
+		~ProfileSlot() { Release(); }
+
+		// Releases the slot, its counters are dropped.
+		void Release();
+	};
 
 	// Alias
 	template <typename T>
@@ -197,9 +705,21 @@ namespace bt
 		// Returns the id of this node.
 		NodeId Id() const { return id; }
 
+		// Returns the stable id of this node, available after tree built.
+		// It's derived from the node's explicit key if given, otherwise from the node's path of names from the
+		// nearest keyed ancestor (or the root), so it won't change if other nodes are inserted or removed.
+		StableNodeId StableId() const { return stableId; }
+
 		// Returns the size of this node, available after tree built.
 		std::size_t Size() const { return size; }
 
+		// Returns the size of this node's blob struct, available after tree built.
+		std::size_t BlobSize() const { return blobSize; }
+
+		// Returns the bytes of heap memory owned by this node, e.g. its name, excluding its children nodes.
+		// Nodes owning containers should override it, to add theirs to the parent class's.
+		virtual std::size_t HeapSize() const;
+
 		// Returns the name of this node.
 		virtual std::string_view Name() const { return name; }
 
@@ -224,6 +744,11 @@ namespace bt
 		// Main entry function, should be called on every tick.
 		Status Tick(const Context& ctx);
 
+		// Batch version of Tick() for entities of given indices in the batch, writes their statuses to
+		// batch.statuses. For each entity, the hooks are called in the same order as Tick().
+		// It's not profiled nor traced.
+		void TickBatch(Batch& batch, std::span<const std::size_t> indices);
+
 		// Public Virtual Functions To Override
 		// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -243,6 +768,11 @@ namespace bt
 		// It's the body part of function Tick().
 		virtual Status Update(const Context& ctx) { return Status::SUCCESS; };
 
+		// Batch version of Update() for entities of given indices in the batch, the body part of TickBatch().
+		// It should write each entity's status to batch.statuses, the same as Update() would return.
+		// By default, it binds the entities' tree blobs and calls Update() one by one.
+		virtual void UpdateBatch(Batch& batch, std::span<const std::size_t> indices);
+
 		// Returns the priority of this node, should be strictly larger than 0, the larger the higher.
 		// By default, all nodes' priorities are equal, to 1.
 		// Providing this method is primarily for selecting children by dynamic priorities.
@@ -255,6 +785,10 @@ namespace bt
 		// Hook function to be called on a blob's first allocation.
 		virtual void OnBlobAllocated(NodeBlob* blob) const {}
 
+		// Returns the bytes of heap memory owned by given blob of this node, and adds the number of heap
+		// allocations to parameter allocations. Nodes whose blobs own containers should override it.
+		virtual std::size_t BlobHeapSize(const NodeBlob* blob, std::size_t& allocations) const { return 0; }
+
 		// Validate whether the node is builded correctly.
 		// Returns error message, empty string for good.
 		virtual std::string_view Validate() const { return ""; }
@@ -288,9 +822,25 @@ namespace bt
 		IRootNode* root = nullptr;
 		// size of this node, available after tree built.
 		std::size_t size = 0;
+		// size of this node's blob struct, available after tree built.
+		std::size_t blobSize = 0;
+		// type of this node's blob struct, available after tree built.
+		const std::type_info* blobType = nullptr;
+		// stable id of this node, available after tree built.
+		StableNodeId stableId = 0;
+		// hash of the explicit key given in the builder, 0 for none.
+		StableNodeId key = 0;
+		// slot of this node's profiling counters, see Profiler.
+		ProfileSlot profileSlot;
+		// the root's binding trace recorder cached, nullptr for none, saves a virtual call on every tick.
+		TraceRecorder* traceRecorder = nullptr;
 
 		// friend with _InternalBuilderBase to access member root, size and id etc.
 		friend class InternalBuilderBase;
+		// friend with TreeBlobMigration to access member blobType.
+		friend class TreeBlobMigration;
+		// friend with RootNode to access member traceRecorder.
+		friend class RootNode;
 	};
 
 	// Concept TNode for all classes derived from Node.
@@ -332,8 +882,28 @@ namespace bt
 		// This method could be overrided.
 		virtual bool Check(const Context& ctx);
 
+		// Checks the condition for entities of given indices in a batch, sets bit i of out if it's satisfied for
+		// the i-th entity. The mask out is sized to the batch, and cleared for the range of the indices.
+		// By default, it calls Check() one by one. Override it to check all at once, e.g. with SIMD over
+		// columns of entities' data, the indices are ascending, and they are a dense range if indices.size()
+		// equals indices.back() - indices.front() + 1. Entities' tree blobs are not bound here.
+		// Code example::
+		//   void CheckBatch(std::span<const bt::Context> contexts, std::span<const std::size_t> indices,
+		//       bt::BatchMask& out) override {
+		//       for (auto i : indices) if (hp[i] < 30) out.Set(i);
+		//   }
+		virtual void CheckBatch(std::span<const Context> contexts, std::span<const std::size_t> indices,
+			BatchMask& out);
+
+		// Checks via CheckBatch().
+		void UpdateBatch(Batch& batch, std::span<const std::size_t> indices) override;
+
+		std::size_t HeapSize() const override;
+
 	private:
 		Checker checker = nullptr;
+		// mask of last batch check.
+		BatchMask mask;
 	};
 
 	using Condition = ConditionNode; // alias
@@ -342,6 +912,89 @@ namespace bt
 	template <typename T>
 	concept TCondition = std::is_base_of_v<ConditionNode, T>;
 
+	// Concept TChecker for callables checking a condition, e.g. lambdas.
+	template <typename F>
+	concept TChecker = std::is_invocable_r_v<bool, F&, const Context&>;
+
+	// LambdaConditionNode is a ConditionNode keeps the concrete type of the checker, instead of type-erasing it
+	// into a std::function, so that the call can be inlined.
+	// Builder methods Condition(), If() and Case() create it for lambdas.
+	template <TChecker F>
+	class LambdaConditionNode final : public ConditionNode
+	{
+	public:
+		explicit LambdaConditionNode(F checker, std::string_view name = "Condition")
+			: ConditionNode(nullptr, name), checker(std::move(checker)) {}
+
+		Status Update(const Context& ctx) override { return checker(ctx) ? Status::SUCCESS : Status::FAILURE; }
+
+		bool Check(const Context& ctx) override { return checker(ctx); }
+
+	private:
+		F checker;
+	};
+
+	/////////////////////////////////////////////////////////////
+	/// Node > LeafNode > ConditionNode > CachedConditionNode
+	/////////////////////////////////////////////////////////////
+
+	// CachedConditionNode is a ConditionNode depending on some slots of the blackboard (Context::blackboard).
+	// It returns the cached result without calling Check(), if none of the dependencies changed since last check
+	// for this entity. So the checker must be a pure function of the dependencies.
+	// Changes are tracked by Blackboard::Set() and Blackboard::Mutable().
+	// It always checks if there's no blackboard in the context.
+	// The cache is stored in the tree blob, so an entity's tree blob should always be ticked with the same blackboard.
+	// Code example::
+	//   root
+	//   .If<bt::CachedConditionNode>(std::vector{ hp.slot }, [=](const bt::Context& ctx) {
+	//       return ctx.blackboard->Get(hp) < 30;
+	//   })
+	//   ._().Action<Flee>()
+	//   .End();
+	class CachedConditionNode : public ConditionNode
+	{
+	public:
+		struct Blob : NodeBlob
+		{
+			bool valid = false;	 // has a cached result?
+			bool result = false; // cached result.
+			ull	 seen = 0;		 // blackboard clock on last check.
+		};
+
+		// Parameter dependencies are the slot indexes of the blackboard keys the checker reads.
+		explicit CachedConditionNode(std::vector<std::size_t> dependencies, Checker checker = nullptr,
+			std::string_view name = "CachedCondition");
+
+		Status Update(const Context& ctx) override final;
+
+		// Checks one by one via Update(), since the cache is per entity.
+		void UpdateBatch(Batch& batch, std::span<const std::size_t> indices) override final
+		{
+			Node::UpdateBatch(batch, indices);
+		}
+
+		NodeBlob* GetNodeBlob() const override { return GetNodeBlobHelper<Blob>(); }
+
+		// Returns the number of the checks answered by the cache.
+		ull NumHits() const { return hits.load(std::memory_order_relaxed); }
+
+		// Returns the number of the checks evaluated.
+		ull NumMisses() const { return misses.load(std::memory_order_relaxed); }
+
+		std::size_t HeapSize() const override;
+
+	protected:
+		// Adds a dependency, for subclasses to call in constructors.
+		template <typename T>
+		void DependsOn(BlackboardKey<T> key) { dependencies.push_back(key.slot); }
+
+	private:
+		std::vector<std::size_t> dependencies;
+		std::atomic<ull>		 hits = 0, misses = 0;
+	};
+
+	using CachedCondition = CachedConditionNode; // alias
+
 	////////////////////////////////////
 	/// Node > LeafNode > ActionNode
 	/////////////////////////////////////
@@ -362,6 +1015,268 @@ namespace bt
 	template <typename T>
 	concept TAction = std::is_base_of_v<ActionNode, T>;
 
+	/////////////////////////////////////////////////////////
+	/// Node > LeafNode > ActionNode > CoroutineActionNode
+	/////////////////////////////////////////////////////////
+
+	// Signal can be awaited by coroutine actions, the awaiting coroutines will be resumed after it's emitted.
+	class Signal
+	{
+	public:
+		// Wakes up all coroutines awaiting on this signal.
+		void Emit() { ++version; }
+
+		// Returns the number of emits.
+		ull Version() const { return version; }
+
+	private:
+		ull version = 0;
+	};
+
+	// Tag type of awaitable NextTick.
+	struct NextTickTag
+	{
+	};
+
+	// Tag type of awaitable Delay.
+	struct DelayTag
+	{
+		std::chrono::nanoseconds duration;
+	};
+
+	// Awaitable to suspend a coroutine action until next tick.
+	// The awaiting expression returns the context of the tick it's resumed at.
+	// Code example::
+	//   const bt::Context& ctx2 = co_await bt::NextTick;
+	inline constexpr NextTickTag NextTick{};
+
+	// Awaitable to suspend a coroutine action for at least given duration.
+	// Code example::
+	//   co_await bt::Delay(100ms);
+	inline DelayTag Delay(std::chrono::nanoseconds duration) { return { duration }; }
+
+	// Coroutine is the return type of CoroutineActionNode::Run.
+	// Its frame is allocated from the BlobPool instead of the global heap.
+	class Coroutine
+	{
+	public:
+		struct promise_type;
+		using Handle = std::coroutine_handle<promise_type>;
+
+		// What a suspended coroutine is waiting for.
+		enum class Wait
+		{
+			TICK = 0,
+			TIMEPOINT = 1,
+			SIGNAL = 2
+		};
+
+		// Awaiter of the all awaitables, resumes with the current tick's context.
+		struct Awaiter
+		{
+			promise_type& promise;
+
+			bool		   await_ready() const noexcept { return false; }
+			void		   await_suspend(Handle) const noexcept {}
+			const Context& await_resume() const noexcept { return *promise.ctx; }
+		};
+
+		struct promise_type
+		{
+			// Final status from co_return.
+			Status status = Status::RUNNING;
+			// Context of current tick, set before each resuming.
+			const Context* ctx = nullptr;
+			// What the coroutine is waiting for.
+			Wait		  wait = Wait::TICK;
+			Timepoint	  wakeAt;
+			const Signal* signal = nullptr;
+			ull			  signalVersion = 0;
+
+			Coroutine			get_return_object() { return Coroutine(Handle::from_promise(*this)); }
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void				return_value(Status s) { status = s; }
+			void				unhandled_exception() { throw; }
+
+			Awaiter await_transform(NextTickTag);
+			Awaiter await_transform(DelayTag d);
+			Awaiter await_transform(const Signal& s);
+
+			// Returns true if the coroutine is ready to be resumed.
+			bool Ready() const;
+
+			// Frames are allocated from the BlobPool.
+			static void* operator new(std::size_t size);
+			static void	 operator delete(void* p, std::size_t size);
+		};
+
+		explicit Coroutine(Handle h)
+			: h(h) {}
+		Coroutine(Coroutine&& o) noexcept
+			: h(std::exchange(o.h, nullptr)) {}
+		Coroutine(const Coroutine&) = delete;
+		~Coroutine();
+
+		// Releases the ownership of the coroutine handle.
+		Handle Release() { return std::exchange(h, nullptr); }
+
+	private:
+		Handle h;
+	};
+
+	// CoroutineActionNode is an action implemented by a C++20 coroutine, instead of a hand-written state machine
+	// in Update(). The coroutine is started on the node's first run of a round, and resumed on later ticks, where
+	// the node keeps RUNNING until the coroutine returns. Its frame handle is stored in the entity's blob.
+	// Code example::
+	//   class Patrol : public bt::CoroutineActionNode {
+	//    public:
+	//     bt::Coroutine Run(const bt::Context& ctx) override {
+	//       co_await bt::Delay(100ms);
+	//       const auto& ctx2 = co_await bt::NextTick;
+	//       co_return bt::Status::SUCCESS;
+	//     }
+	//   };
+	class CoroutineActionNode : public ActionNode
+	{
+	public:
+		struct Blob : NodeBlob
+		{
+			// The running coroutine.
+			Coroutine::Handle handle = nullptr;
+
+			Blob() = default;
+
+			// The blob owns the coroutine frame: it's moved on relocation, copying is disabled.
+			Blob(Blob&& o) noexcept
+				: NodeBlob(o), handle(std::exchange(o.handle, nullptr)) {}
+			Blob& operator=(Blob&& o) noexcept
+			{
+				if (this != &o)
+				{
+					if (handle)
+						handle.destroy();
+					NodeBlob::operator=(o);
+					handle = std::exchange(o.handle, nullptr);
+				}
+				return *this;
+			}
+			Blob(const Blob&) = delete;
+			Blob& operator=(const Blob&) = delete;
+
+			// Destroys the coroutine frame left running when the blob is dropped.
+			~Blob()
+			{
+				if (handle)
+					handle.destroy();
+			}
+		};
+
+		explicit CoroutineActionNode(std::string_view name = "CoroutineAction")
+			: ActionNode(name) {}
+
+		NodeBlob* GetNodeBlob() const override { return GetNodeBlobHelper<Blob>(); }
+		Status	  Update(const Context& ctx) override final;
+
+		// The coroutine body to be implemented by subclasses, should co_return SUCCESS or FAILURE.
+		// Notes that parameter ctx is the context of the first tick, and it's only safe to access before the
+		// first suspension, use the result of co_await expressions instead later.
+		virtual Coroutine Run(const Context& ctx) = 0;
+	};
+
+	using CoroutineAction = CoroutineActionNode; // alias
+
+	/////////////////////////////////////////////////////////
+	/// Node > LeafNode > ActionNode > AsyncActionNode
+	/////////////////////////////////////////////////////////
+
+	// Executor runs a job somewhere, e.g. submits it to a thread pool.
+	using Executor = std::function<void(std::function<void()>)>;
+
+	// AsyncTask is the completion slot shared by an AsyncActionNode's entity blob and its running work.
+	class AsyncTask
+	{
+	public:
+		// Returns true if the task is cancelled, long running work could check it to quit early.
+		bool Cancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+	private:
+		// Status of the work, RUNNING until it's done.
+		std::atomic<Status> status = Status::RUNNING;
+		std::atomic<bool>	cancelled = false;
+
+		friend class AsyncActionNode;
+	};
+
+	// AsyncActionNode offloads expensive work to a user-provided executor, instead of doing it inline in Update().
+	// The work is submitted on the node's first run of a round, the node keeps RUNNING and polls the completion
+	// on later ticks, and never blocks on the work.
+	// Code example::
+	//   class FindPath : public bt::AsyncActionNode {
+	//    public:
+	//     using bt::AsyncActionNode::AsyncActionNode;
+	//     Work MakeWork(const bt::Context& ctx) override {
+	//       return [from, to](const bt::AsyncTask& task) { return Search(from, to) ? SUCCESS : FAILURE; };
+	//     }
+	//   };
+	//   root.Action<FindPath>(executor);
+	class AsyncActionNode : public ActionNode
+	{
+	public:
+		// Work is the job to run on the executor, it should return SUCCESS or FAILURE.
+		using Work = std::function<Status(const AsyncTask& task)>;
+
+		struct Blob : NodeBlob
+		{
+			// The submitted task, nullptr for none.
+			std::shared_ptr<AsyncTask> task;
+
+			Blob() = default;
+
+			// The blob owns the task: it's moved on relocation without cancelling, copying is disabled.
+			Blob(Blob&& o) noexcept
+				: NodeBlob(o), task(std::move(o.task)) { o.task = nullptr; }
+			Blob& operator=(Blob&& o) noexcept
+			{
+				if (this != &o)
+				{
+					if (task != nullptr)
+						task->cancelled.store(true, std::memory_order_relaxed);
+					NodeBlob::operator=(o);
+					task = std::move(o.task);
+					o.task = nullptr;
+				}
+				return *this;
+			}
+			Blob(const Blob&) = delete;
+			Blob& operator=(const Blob&) = delete;
+
+			// Cancels the pending task when the blob is dropped, e.g. the entity dies or respawns by resetting its
+			// tree blob. A node preempted by its parent keeps its task running until then.
+			~Blob()
+			{
+				if (task != nullptr)
+					task->cancelled.store(true, std::memory_order_relaxed);
+			}
+		};
+
+		explicit AsyncActionNode(Executor executor, std::string_view name = "AsyncAction")
+			: ActionNode(name), executor(std::move(executor)) {}
+
+		NodeBlob* GetNodeBlob() const override { return GetNodeBlobHelper<Blob>(); }
+		Status	  Update(const Context& ctx) override;
+
+		// Makes the work to submit, it's called on the ticking thread.
+		// Since the work runs on the executor, it should capture what it needs by value, rather than the ctx.
+		virtual Work MakeWork(const Context& ctx) = 0;
+
+		// Cancels the pending task of current entity, if any.
+		void Cancel();
+
+	protected:
+		Executor executor;
+	};
+
 	////////////////////////////
 	/// Node > InternalNode
 	////////////////////////////
@@ -418,6 +1333,8 @@ namespace bt
 		// Returns the max priority of considerable children.
 		unsigned int Priority(const Context& ctx) const final override;
 
+		std::size_t HeapSize() const override;
+
 	protected:
 		PtrList<Node> children;
 
@@ -450,9 +1367,10 @@ namespace bt
 			std::vector<bool> st;
 		};
 
-		NodeBlob* GetNodeBlob() const override { return GetNodeBlobHelper<Blob>(); }
-		void	  OnTerminate(const Context& ctx, Status status) override;
-		void	  OnBlobAllocated(NodeBlob* blob) const override;
+		NodeBlob*	GetNodeBlob() const override { return GetNodeBlobHelper<Blob>(); }
+		void		OnTerminate(const Context& ctx, Status status) override;
+		void		OnBlobAllocated(NodeBlob* blob) const override;
+		std::size_t BlobHeapSize(const NodeBlob* blob, std::size_t& allocations) const override;
 
 	protected:
 		bool IsParatialConsidered() const override { return true; }
@@ -479,6 +1397,9 @@ namespace bt
 		void SetQ1Container(std::vector<int>* c);
 		void ResetQ1Container(void) { q1 = &q1Container; }
 
+		// Returns the bytes of heap memory owned by the queues.
+		std::size_t HeapSize() const;
+
 	private:
 		// hacking a private priority_queue for the stl missing `reserve` and `clear` method.
 		template <typename T, typename Container = std::vector<T>>
@@ -490,8 +1411,9 @@ namespace bt
 			explicit InternalPriorityQueue(Cmp cmp)
 				: std::priority_queue<T, Container, Cmp>(cmp) {}
 
-			void Reserve(std::size_t n) { this->c.reserve(n); }
-			void Clear() { this->c.clear(); }
+			void		Reserve(std::size_t n) { this->c.reserve(n); }
+			void		Clear() { this->c.clear(); }
+			std::size_t Capacity() const { return this->c.capacity(); }
 		};
 
 		// use a pre-allocated vector instead of a std::queue, q1 will be pushed all and then poped all,
@@ -511,6 +1433,12 @@ namespace bt
 		InternalPriorityCompositeNode() {}
 		Status Update(const Context& ctx) override;
 
+		// Ticks the batch in a wavefront via InternalUpdateBatch(), if priorities of considerable children are all
+		// equal for every entity, otherwise ticks the entities one by one.
+		void UpdateBatch(Batch& batch, std::span<const std::size_t> indices) override;
+
+		std::size_t HeapSize() const override;
+
 	protected:
 		// Prepare priorities of considerable children on every tick.
 		// p[i] stands for i'th child's priority.
@@ -541,6 +1469,18 @@ namespace bt
 		// An internal method to propagates tick() to children in the q1/q2.
 		// it will be called by Update.
 		virtual Status InternalUpdate(const Context& ctx) { return bt::Status::UNDEFINED; }
+
+		// Batch version of InternalUpdate, with children in order for every entity.
+		// It will be called by UpdateBatch, by default it ticks the entities one by one.
+		virtual void InternalUpdateBatch(Batch& batch, std::span<const std::size_t> indices);
+
+		// Splits given entities by whether the i'th child is considerable, keeps the orders.
+		void SplitConsiderable(Batch& batch, int i, std::span<const std::size_t> indices,
+			std::vector<std::size_t>& considered, std::vector<std::size_t>& skipped);
+
+		// Scratch indices of entities for wavefront ticking, refreshed on each batch tick, so they're stateless.
+		// wave is the entities still going on, ticking is the entities to tick the current child.
+		std::vector<std::size_t> wave, ticking, next;
 	};
 
 	//////////////////////////////////////////////////////////////
@@ -552,6 +1492,7 @@ namespace bt
 	{
 	protected:
 		Status InternalUpdate(const Context& ctx) override;
+		void   InternalUpdateBatch(Batch& batch, std::span<const std::size_t> indices) override;
 	};
 
 	// SequenceNode runs children one by one, and succeeds only if all children succeed.
@@ -582,6 +1523,7 @@ namespace bt
 	{
 	protected:
 		Status InternalUpdate(const Context& ctx) override;
+		void   InternalUpdateBatch(Batch& batch, std::span<const std::size_t> indices) override;
 	};
 
 	// SelectorNode succeeds if any child succeeds.
@@ -613,6 +1555,12 @@ namespace bt
 	{
 	public:
 		Status Update(const Context& ctx) override;
+
+		// Ticks the entities one by one.
+		void UpdateBatch(Batch& batch, std::span<const std::size_t> indices) override
+		{
+			Node::UpdateBatch(batch, indices);
+		}
 	};
 
 	// RandomSelectorNode selects children via weighted random selection.
@@ -641,8 +1589,26 @@ namespace bt
 
 	class InternalParallelNodeBase : virtual public InternalPriorityCompositeNode
 	{
+	public:
+		std::size_t HeapSize() const override;
+
 	protected:
 		Status InternalUpdate(const Context& ctx) override;
+		void   InternalUpdateBatch(Batch& batch, std::span<const std::size_t> indices) override;
+
+		// Counts the status of the ticked i'th child, and calls the OnChildXXX hooks.
+		void OnChildTicked(const int i, Status status, int& cntSuccess, int& cntFailure);
+
+		// Returns the aggregated status: S if all children S, F if any child F, otherwise R.
+		static Status Aggregate(int cntSuccess, int cntFailure, int total);
+
+	private:
+		struct Counts
+		{
+			int success = 0, failure = 0, total = 0;
+		};
+		// Counts of children statuses for each entity in current batch tick, so it's stateless.
+		std::vector<Counts> counts;
 	};
 
 	// ParallelNode succeeds if all children succeed but runs all children
@@ -666,6 +1632,45 @@ namespace bt
 		void OnChildSuccess(const int i);
 	};
 
+	// ConcurrentParallelNode behaves like a ParallelNode, but dispatches its children to an executor (e.g. a thread
+	// pool) to tick them concurrently, and joins them within the tick.
+	// The children's subtrees should be independent with each other, and the executor should run jobs
+	// concurrently, but not on the ticking thread.
+	// If the executor throws, it must not have run the job, the exception is rethrown after the jobs already
+	// dispatched finish.
+	// It falls back to tick children sequentially if the total number of nodes under considerable children is
+	// below given threshold.
+	class ConcurrentParallelNode final : public InternalParallelNodeBase
+	{
+	public:
+		explicit ConcurrentParallelNode(Executor executor, std::size_t threshold = 0,
+			std::string_view name = "ConcurrentParallel", PtrList<Node>&& cs = {});
+
+		std::size_t HeapSize() const override;
+
+	protected:
+		void   InternalOnBuild() override;
+		Status InternalUpdate(const Context& ctx) override;
+
+		// Ticks the entities one by one, each ticks children concurrently.
+		void InternalUpdateBatch(Batch& batch, std::span<const std::size_t> indices) override
+		{
+			Node::UpdateBatch(batch, indices);
+		}
+
+	private:
+		Executor	executor;
+		std::size_t threshold;
+		// w[i] is the number of nodes in i'th child's subtree.
+		std::vector<std::size_t> w;
+		// Indexes and statuses of children to tick, refreshed on each tick, so it's stateless.
+		std::vector<int>				indexes;
+		std::vector<Status>				statuses;
+		std::vector<std::exception_ptr> errors;
+		// Number of pending children during a tick.
+		std::unique_ptr<std::atomic<int>> pending;
+	};
+
 	//////////////////////////////////////////////////////////////
 	/// Node > InternalNode > CompositeNode > Decorator
 	///////////////////////////////////////////////////////////////
@@ -687,6 +1692,7 @@ namespace bt
 	public:
 		explicit InvertNode(std::string_view name = "Invert", Ptr<Node> child = nullptr);
 		Status Update(const Context& ctx) override;
+		void   UpdateBatch(Batch& batch, std::span<const std::size_t> indices) override;
 	};
 
 	// ConditionalRunNode executes its child if given condition returns true.
@@ -700,9 +1706,16 @@ namespace bt
 
 		Status Update(const Context& ctx) override;
 
+		// Checks the condition for all the entities first, then ticks the child for the passed ones.
+		void UpdateBatch(Batch& batch, std::span<const std::size_t> indices) override;
+
+		std::size_t HeapSize() const override;
+
 	private:
 		// Condition node to check.
 		Ptr<Node> condition;
+		// indices of the entities passed the condition in current batch tick.
+		std::vector<std::size_t> passed;
 	};
 
 	// RepeatNode repeats its child for exactly n times.
@@ -733,8 +1746,6 @@ namespace bt
 		int n;
 	};
 
-	using Timepoint = std::chrono::time_point<std::chrono::steady_clock>;
-
 	// Timeout runs its child for at most given duration, fails on timeout.
 	class TimeoutNode : public DecoratorNode
 	{
@@ -837,6 +1848,28 @@ namespace bt
 
 		Status Update(const Context& ctx) override;
 
+		void UpdateBatch(Batch& batch, std::span<const std::size_t> indices) override;
+
+		// Ticks the tree for a batch of entities at once, the i-th entity is ticked with contexts[i] on tree blob
+		// blobs[i], and its status is written to statuses[i]. The results are the same as binding each tree blob
+		// and calling Tick() one by one, as long as entities don't share states.
+		// The entities go through the tree node by node as a wavefront, chunk by chunk, each node is ticked once
+		// for all entities of a chunk reaching it: a ConditionalRun node checks its condition for them via
+		// ConditionNode::CheckBatch() before descending, composite nodes partition them by children's statuses,
+		// and leaves overriding UpdateBatch() receive them as a whole.
+		// Parameter chunk is the max number of entities of a wavefront, to keep their node blobs in cache.
+		// The bound tree blob is restored afterwards.
+		// Code example::
+		//   std::vector<bt::Context> contexts(n);
+		//   std::vector<bt::ITreeBlob*> blobs(n);
+		//   std::vector<bt::Status> statuses(n);
+		//   for (auto& ctx : contexts) ++ctx.seq;
+		//   root.TickBatch(contexts, blobs, statuses);
+		void TickBatch(std::span<const Context> contexts, std::span<ITreeBlob* const> blobs,
+			std::span<Status> statuses, std::size_t chunk = 256);
+
+		using SingleNode::TickBatch;
+
 		// Visualize the tree to console.
 		void Visualize(ull seq);
 
@@ -844,9 +1877,22 @@ namespace bt
 		// Parameter interval specifies the time interval between ticks.
 		// Parameter visualize enables debugging visualization on the console.
 		// Parameter is a hook to be called after each tick.
+		// The ctx.delta is the measured time since last tick, and it sleeps only for the rest of the interval.
+		// For drift-free fixed timesteps and stop/pause control, use the overload on a FixedTicker instead.
 		void TickForever(Context& ctx, std::chrono::nanoseconds interval, bool visualize = false,
 			std::function<void(const Context&)> post = nullptr);
 
+		// Runs tick loop on given fixed-timestep ticker, until it's stopped.
+		// The ctx.delta is the fixed timestep of each tick.
+		// Code example::
+		//   bt::FixedTicker ticker(16ms, bt::FixedTicker::Policy::Skip, bt::FixedTicker::Hybrid());
+		//   std::thread t([&] { root.TickForever(ctx, ticker); });
+		//   ...
+		//   ticker.Stop();
+		//   t.join();
+		void TickForever(Context& ctx, FixedTicker& ticker, bool visualize = false,
+			std::function<void(const Context&)> post = nullptr);
+
 		/// Blob Apis
 		/// ~~~~~~~~~
 
@@ -859,6 +1905,18 @@ namespace bt
 		// Unbind current tree blob.
 		void UnbindTreeBlob() { blob = nullptr; }
 
+		/// Trace Apis
+		/// ~~~~~~~~~~
+
+		// Binds a trace recorder, which records every node's ticks until unbound.
+		void BindTraceRecorder(TraceRecorder& r);
+
+		// Returns current trace recorder.
+		TraceRecorder* GetTraceRecorder(void) const override { return recorder; }
+
+		// Unbind current trace recorder.
+		void UnbindTraceRecorder();
+
 		/// Size Info
 		/// ~~~~~~~~~
 
@@ -878,9 +1936,35 @@ namespace bt
 		// Available once the tree is built.
 		std::size_t MaxSizeNodeBlob() const { return maxSizeNodeBlob; }
 
+		// Reports the memory usage of this tree, and the per-entity memory measured on given tree blob if
+		// it's not nullptr. Nodes' heap memory is reported by Node::HeapSize(), node blobs' by Node::BlobHeapSize().
+		// Code example::
+		//   auto report = root.ReportMemory(&entity.blob);
+		//   auto fleet = report.nodeBytes + report.nodeHeapBytes + n * (report.blobReservedBytes + report.blobHeapBytes);
+		MemoryReport ReportMemory(ITreeBlob* b = nullptr);
+
+		std::size_t HeapSize() const override;
+
+		/// Stable Id Apis
+		/// ~~~~~~~~~~~~~~
+
+		// Returns the id of the node with given stable id, 0 for not found.
+		// Available once the tree is built.
+		NodeId FindNodeId(StableNodeId stableId) const;
+
+		// Returns the stable id of the node with given id.
+		// Available once the tree is built.
+		StableNodeId StableIdOf(NodeId id) const { return stableIds[id - 1]; }
+
 	protected:
 		// Current binding tree blob.
 		ITreeBlob* blob = nullptr;
+		// Current binding trace recorder.
+		TraceRecorder* recorder = nullptr;
+		// indices of all entities of current batch tick.
+		std::vector<std::size_t> batchIndices;
+		// node blobs stack for batch ticks, reused across ticks.
+		std::vector<NodeBlob*> batchNodeBlobs;
 		// Number of nodes on this tree, including the root itself.
 		int n = 0;
 		// Size of this tree.
@@ -889,10 +1973,47 @@ namespace bt
 		std::size_t maxSizeNode = 0;
 		// MaxSizeNodeBlob is the max size of tree node blobs.
 		std::size_t maxSizeNodeBlob = 0;
+		// Dense remap table from node id to stable id, indexed by id-1.
+		std::vector<StableNodeId> stableIds;
+		// Remap table from stable id to node id.
+		std::unordered_map<StableNodeId, NodeId> nodeIds;
 
 		friend class InternalBuilderBase; // for access to n, treeSize, maxSizeNode, maxSizeNodeBlob;
 	};
 
+	//////////////////////////////////////////////////////////////
+	/// TreeBlob Migration
+	///////////////////////////////////////////////////////////////
+
+	// TreeBlobMigration migrates entities' tree blobs from an old tree to a new tree, e.g. on hot reloading of a
+	// tree definition, without rebuilding any entity.
+	// A node's blob is kept only if the node's stable id, blob type and children are unchanged in the new tree,
+	// and it's moved to the node's new id. Blobs of the other nodes are dropped, they start freshly.
+	// Stable ids don't change if other nodes are inserted or removed, see Node::StableId().
+	// The migration plan is made once, and then applied to every entity's blob.
+	// FixedTreeBlob and SizedTreeBlob are migrated in place, the plan's moves go through a single scratch cell.
+	// Code example::
+	//   bt::TreeBlobMigration migration(oldRoot, newRoot);
+	//   for (auto& e : entities)
+	//     migration.Apply(e.blob);
+	class TreeBlobMigration
+	{
+	public:
+		TreeBlobMigration(RootNode& from, RootNode& to);
+
+		// Migrates given tree blob in place.
+		// The blob should be built for the old tree, and then it's ready for the new tree.
+		void Apply(ITreeBlob& blob) const;
+
+		// Returns the number of nodes whose blobs are kept.
+		int NumKept() const { return numKept; }
+
+	private:
+		// plan.src[i] is the index of the blob in old tree to move to index i in new tree, -1 for none.
+		ITreeBlob::RemapPlan plan;
+		int					 numKept = 0;
+	};
+
 	//////////////////////////////////////////////////////////////
 	/// Tree Builder
 	///////////////////////////////////////////////////////////////
@@ -905,6 +2026,8 @@ namespace bt
 		// indent level to insert new node, starts from 1.
 		int		  level = 1;
 		RootNode* root = nullptr;
+		// the last attached node.
+		Node* last = nullptr;
 
 		InternalBuilderBase()
 			: level(1) {}
@@ -912,7 +2035,7 @@ namespace bt
 		template <TNode T>
 		void OnNodeAttach(T& node, RootNode* root);
 
-		void OnRootAttach(RootNode* root, std::size_t size, std::size_t blobSize);
+		void OnRootAttach(RootNode* root, std::size_t size, std::size_t blobSize, const std::type_info& blobType);
 		void OnSubtreeAttach(RootNode& subtree, RootNode* root);
 		void OnNodeBuild(Node* node);
 
@@ -931,6 +2054,12 @@ namespace bt
 		void AttachLeafNode(Ptr<LeafNode> p);
 		void AttachInternalNode(Ptr<InternalNode> p);
 
+		// Sets an explicit key to the last attached node.
+		void SetKey(std::string_view key);
+
+		// Maintains stable ids of all nodes in the tree, should be called on the end of the build process.
+		void MaintainStableIds(RootNode* root);
+
 	private:
 		// Node id incrementer for a tree.
 		// unique inside this builder instance.
@@ -938,6 +2067,8 @@ namespace bt
 
 		void MaintainNodeBindInfo(Node& node, RootNode* root);
 
+		void MaintainNodeBlobInfo(Node& node, const std::type_info& blobType);
+
 		void MaintainSizeInfoOnRootBind(RootNode* root, std::size_t rootNodeSize, std::size_t blobSize);
 
 		void MaintainSizeInfoOnNodeAttach(Node& node, RootNode* root, std::size_t nodeSize,
@@ -968,6 +2099,19 @@ namespace bt
 			return static_cast<D&>(*this);
 		}
 
+		// Gives the last attached node an explicit key, from which its stable id is derived.
+		// Keys should be unique inside a tree.
+		// Code exapmle::
+		//    root
+		//    .Sequence()
+		//    ._().Action<A>().Key("attack")
+		//    .End();
+		auto& Key(std::string_view key)
+		{
+			SetKey(key);
+			return static_cast<D&>(*this);
+		}
+
 		// General creators
 		// ~~~~~~~~~~~~~~~~
 
@@ -1015,6 +2159,14 @@ namespace bt
 		// "already success" children instead of executing every child all the time.
 		auto& StatefulParallel() { return C<StatefulParallelNode>("Parallel*"); }
 
+		// A ConcurrentParallelNode behaves like a parallel node, but ticks its children concurrently on the
+		// given executor, and joins them within the tick.
+		// It ticks children sequentially if the total number of nodes under them is below the threshold.
+		auto& ConcurrentParallel(Executor executor, std::size_t threshold = 0)
+		{
+			return C<ConcurrentParallelNode>(executor, threshold, "ConcurrentParallel");
+		}
+
 		// A RandomSelectorNode determines a child via weighted random selection.
 		// It continues to randomly select a child, propagating tick, until some child succeeds.
 		auto& RandomSelector() { return C<RandomSelectorNode>("RandomSelector"); }
@@ -1034,14 +2186,18 @@ namespace bt
 		template <TAction Impl, typename... Args>
 		auto& Action(Args&&... args);
 
-		// Creates a ConditionNode from a lambda function.
+		// Creates a ConditionNode from a std::function checker.
+		auto& Condition(ConditionNode::Checker checker) { return C<ConditionNode>(checker); }
+
+		// Creates a LambdaConditionNode from a lambda function, keeping its concrete type.
 		// Code example::
 		//   root
 		//   .Sequence()
 		//   ._().Condition([=](const Context& ctx) { return false;})
 		//   ._().Action<A>()
 		//   .End();
-		auto& Condition(ConditionNode::Checker checker) { return C<ConditionNode>(checker); }
+		template <TChecker F>
+		auto& Condition(F checker) { return C<LambdaConditionNode<F>>(std::move(checker)); }
 
 		// Creates a ConditionNode by providing implemented Condition class.
 		// Code example::
@@ -1156,12 +2312,16 @@ namespace bt
 		template <TCondition Condition, typename... ConditionArgs>
 		auto& If(ConditionArgs&&... args);
 
-		// If creates a ConditionalRunNode from lambda function.
+		// If creates a ConditionalRunNode from a std::function checker.
+		auto& If(ConditionNode::Checker checker) { return If<ConditionNode>(checker); }
+
+		// If creates a ConditionalRunNode from lambda function, keeping its concrete type.
 		// Code example::
 		//  root
 		//  .If([=](const Context& ctx) { return false; })
 		//  .End();
-		auto& If(ConditionNode::Checker checker) { return If<ConditionNode>(checker); }
+		template <TChecker F>
+		auto& If(F checker) { return If<LambdaConditionNode<F>>(std::move(checker)); }
 
 		// Switch is just an alias to Selector.
 		// Code example::
@@ -1183,9 +2343,13 @@ namespace bt
 		template <TCondition Condition, typename... ConditionArgs>
 		auto& Case(ConditionArgs&&... args);
 
-		// Case creates a ConditionalRunNode from lambda function.
+		// Case creates a ConditionalRunNode from a std::function checker.
 		auto& Case(ConditionNode::Checker checker) { return Case<ConditionNode>(checker); }
 
+		// Case creates a ConditionalRunNode from lambda function, keeping its concrete type.
+		template <TChecker F>
+		auto& Case(F checker) { return Case<LambdaConditionNode<F>>(std::move(checker)); }
+
 		// Subtree creators
 		// ~~~~~~~~~~~~~~~~
 
@@ -1230,17 +2394,567 @@ namespace bt
 		explicit Tree(std::string_view name = "Root");
 	};
 
+	//////////////////////////////////////////////////////////////
+	/// Tick Drivers
+	///////////////////////////////////////////////////////////////
+
+	// BudgetedTicker ticks as many entities as fit in a time budget per frame, and resumes where it left off on the
+	// next frame, in a round-robin way. So the deferred entities are ticked first on the next frame, no entity starves
+	// under load spikes. At least one entity is ticked per frame, and an entity is ticked at most once per frame.
+	// Entities are identified by indexes in [0, Size()).
+	// Code example::
+	//   bt::BudgetedTicker ticker(entities.size());
+	//   // On each frame.
+	//   auto& stats = ticker.Tick(std::chrono::microseconds(2000), [&](std::size_t i, std::chrono::nanoseconds delta) {
+	//     auto& e = entities[i];
+	//     e.ctx.delta = delta;
+	//     ++e.ctx.seq;
+	//     root.BindTreeBlob(e.blob);
+	//     root.Tick(e.ctx);
+	//     root.UnbindTreeBlob();
+	//   });
+	class BudgetedTicker
+	{
+	public:
+		// Function to tick the entity at given index.
+		// Parameter delta is the time since this entity's last tick, 0 for its first tick.
+		using TickFunc = std::function<void(std::size_t idx, std::chrono::nanoseconds delta)>;
+
+		// Statistics of a frame.
+		struct Stats
+		{
+			// Number of entities ticked.
+			std::size_t ticked = 0;
+			// Number of entities deferred to later frames.
+			std::size_t deferred = 0;
+			// Max number of frames the deferred entities have been waiting since their last ticks.
+			ull maxStarvation = 0;
+			// Time spent on this frame.
+			std::chrono::nanoseconds elapsed{ 0 };
+		};
+
+		explicit BudgetedTicker(std::size_t n = 0) { Resize(n); }
+
+		// Changes the number of entities, the new ones are ticked after the existing ones.
+		void Resize(std::size_t n);
+
+		// Returns the number of entities.
+		std::size_t Size() const { return lastTickAt.size(); }
+
+		// Ticks entities within given time budget, returns this frame's statistics.
+		const Stats& Tick(std::chrono::nanoseconds budget, const TickFunc& f);
+
+		// Returns the statistics of the last frame.
+		const Stats& LastStats() const { return stats; }
+
+	private:
+		// Index of the next entity to tick.
+		std::size_t cursor = 0;
+		// Current frame number, starts from 1.
+		ull frame = 0;
+		// Timepoint of each entity's last tick, default for never ticked.
+		std::vector<Timepoint> lastTickAt;
+		// Frame number of each entity's last tick.
+		std::vector<ull> lastTickFrame;
+		Stats			 stats;
+	};
+
+	// LodTicker ticks entities at different rates by their levels of detail, e.g. nearby entities every frame,
+	// distant or idle ones every 4 or 16 frames.
+	// Entities are bucketed by their tick periods, and entities of the same period are staggered evenly across
+	// frames, so that the load of each frame is balanced.
+	// The delta passed to an entity is the accumulated time of the frames since its last tick, so time-based nodes
+	// (e.g. Timeout, Delay) still behave correctly.
+	// Entities are identified by indexes in [0, Size()), the default period is 1.
+	// Code example::
+	//   bt::LodTicker ticker(entities.size());
+	//   ticker.SetPeriod(i, 16); // ticks entity i every 16 frames.
+	//   // On each frame.
+	//   ticker.Tick(frameDelta, [&](std::size_t i, std::chrono::nanoseconds delta) {
+	//     auto& e = entities[i];
+	//     e.ctx.delta = delta;
+	//     ++e.ctx.seq;
+	//     root.BindTreeBlob(e.blob);
+	//     root.Tick(e.ctx);
+	//     root.UnbindTreeBlob();
+	//   });
+	class LodTicker
+	{
+	public:
+		// Function to tick the entity at given index.
+		// Parameter delta is the accumulated time since this entity's last tick, 0 for its first tick.
+		// It shouldn't call SetPeriod() or Resize().
+		using TickFunc = std::function<void(std::size_t idx, std::chrono::nanoseconds delta)>;
+
+		explicit LodTicker(std::size_t n = 0) { Resize(n); }
+
+		// Changes the number of entities, the new ones are of period 1.
+		void Resize(std::size_t n);
+
+		// Returns the number of entities.
+		std::size_t Size() const { return entities.size(); }
+
+		// Sets the tick period of the entity at given index, it will be ticked every period frames.
+		// Throws if period is 0.
+		void SetPeriod(std::size_t idx, unsigned int period);
+
+		// Returns the tick period of the entity at given index.
+		unsigned int Period(std::size_t idx) const { return entities[idx].period; }
+
+		// Advances a frame of given delta time, ticks the entities due on this frame.
+		// Returns the number of entities ticked.
+		std::size_t Tick(std::chrono::nanoseconds frameDelta, const TickFunc& f);
+
+	private:
+		struct Entity
+		{
+			unsigned int period = 0; // 0 for not bucketed.
+			unsigned int phase = 0;	 // ticked on frames where frame % period == phase.
+			std::size_t	 pos = 0;	 // position in the phase's list.
+			bool		 ticked = false;
+			// Total time elapsed on last tick.
+			std::chrono::nanoseconds lastTickAt{ 0 };
+		};
+
+		struct Bucket
+		{
+			unsigned int						  period;
+			std::vector<std::vector<std::size_t>> phases; // phase => entity indexes.
+		};
+
+		void Insert(std::size_t idx, unsigned int period);
+		void Remove(std::size_t idx);
+
+		ull						 frame = 0;
+		std::chrono::nanoseconds elapsed{ 0 }; // total time elapsed.
+		std::vector<Entity>		 entities;
+		std::vector<Bucket>		 buckets;
+	};
+
+	// FixedTicker runs a drift-free fixed-timestep loop: the deadline of the k-th tick is start + k * interval,
+	// regardless of how long the ticks take.
+	// When ticks overrun and deadlines are missed, the policy decides:
+	//   CatchUp: ticks the missed ones immediately, up to maxCatchUp in a row, then skips the rest.
+	//   Skip: drops the missed ones, the next tick's delta covers the skipped time.
+	// The loop can be stopped, paused and resumed from any thread (or from the tick function).
+	// Code example::
+	//   bt::FixedTicker ticker(1ms, bt::FixedTicker::Policy::CatchUp, bt::FixedTicker::Hybrid(200us));
+	//   ticker.Run([&](std::chrono::nanoseconds delta) { ... });
+	class FixedTicker
+	{
+	public:
+		enum class Policy
+		{
+			CatchUp = 0,
+			Skip = 1
+		};
+
+		// Function to wait until given deadline.
+		using SleepStrategy = std::function<void(Timepoint deadline)>;
+
+		// Function to tick, parameter delta is the simulated time of this tick.
+		using TickFunc = std::function<void(std::chrono::nanoseconds delta)>;
+
+		// Statistics of the loop.
+		struct Stats
+		{
+			// Number of ticks.
+			ull ticks = 0;
+			// Number of ticks finished after the next tick's deadline.
+			ull overruns = 0;
+			// Number of ticks skipped.
+			ull skipped = 0;
+			// Max and total lateness of the ticks started on schedule (not catching up).
+			std::chrono::nanoseconds maxJitter{ 0 };
+			std::chrono::nanoseconds totalJitter{ 0 };
+			ull						 numJitterSamples = 0;
+
+			// Returns the mean lateness of the ticks started on schedule.
+			std::chrono::nanoseconds MeanJitter() const
+			{
+				if (numJitterSamples == 0)
+					return std::chrono::nanoseconds(0);
+				return std::chrono::duration_cast<std::chrono::nanoseconds>(totalJitter / numJitterSamples);
+			}
+		};
+
+		// Builtin sleep strategies.
+		// Sleep sleeps until the deadline, cheap but the wake up may be late by the OS scheduler's resolution.
+		static void Sleep(Timepoint deadline);
+		// Spin busy-waits until the deadline, precise but burns a cpu.
+		static void Spin(Timepoint deadline);
+		// Hybrid sleeps until a bit earlier than the deadline, then spins for the last spinThreshold.
+		static SleepStrategy Hybrid(std::chrono::nanoseconds spinThreshold = std::chrono::milliseconds(2));
+
+		// Parameter sleep defaults to Sleep if nullptr.
+		FixedTicker(std::chrono::nanoseconds interval, Policy policy = Policy::CatchUp, SleepStrategy sleep = nullptr,
+			std::size_t maxCatchUp = 5);
+
+		// Runs the loop until stopped, returns immediately if already stopped.
+		void Run(const TickFunc& f);
+
+		// Stops the loop, Run() returns after current tick or sleep.
+		void Stop();
+
+		// Pauses the loop, no ticks until resumed.
+		// On resumed, the schedule restarts from the resume time, the paused time isn't caught up.
+		void Pause();
+
+		// Resumes a paused loop.
+		void Resume();
+
+		bool Stopped() const { return state.load() == STOPPED; }
+		bool Paused() const { return state.load() == PAUSED; }
+
+		// Returns the statistics.
+		// Should be called on the ticking thread (e.g. inside the tick function), or after Run() returns.
+		const Stats& GetStats() const { return stats; }
+
+		std::chrono::nanoseconds Interval() const { return interval; }
+
+	private:
+		enum : int
+		{
+			RUNNING = 0,
+			PAUSED = 1,
+			STOPPED = 2
+		};
+
+		std::chrono::nanoseconds interval;
+		Policy					 policy;
+		SleepStrategy			 sleep;
+		std::size_t				 maxCatchUp;
+		std::atomic<int>		 state = RUNNING;
+		Stats					 stats;
+	};
+
+	//////////////////////////////////////////////////////////////
+	/// Profiling
+	///////////////////////////////////////////////////////////////
+
+	// NodeProfile is the profiling statistics of a node, merged from all threads.
+	struct NodeProfile
+	{
+		// Number of histogram buckets.
+		static constexpr std::size_t NumBuckets = 40;
+
+		std::string	 name;
+		NodeId		 id = 0;
+		StableNodeId stableId = 0;
+		// Number of Tick() calls.
+		ull calls = 0;
+		// Number of returned statuses, indexed by Status.
+		ull statuses[4] = {};
+		// Total time spent in this node's Tick(), excluding (self) or including (inclusive) its children's.
+		std::chrono::nanoseconds self{ 0 };
+		std::chrono::nanoseconds inclusive{ 0 };
+		// Histogram of inclusive time per call, bucket i counts the calls took [2^i, 2^(i+1)) nanoseconds.
+		ull histogram[NumBuckets] = {};
+
+		// Returns the approximate inclusive time per call at given percentile p in [0, 1], e.g. 0.99.
+		// It's the upper bound of the histogram bucket.
+		std::chrono::nanoseconds Percentile(double p) const;
+	};
+
+	// Profiler collects per-node call counts, status counts and timings of Node::Tick.
+	// It's compiled out entirely unless bt.cc is compiled with macro BT_ENABLE_PROFILING defined,
+	// then Collect() returns nothing.
+	// Counters are recorded in per-thread storage, and merged on demand, so it works with concurrent ticking.
+	// Nodes are recorded per node instance, not per entity, the counters of destroyed nodes are dropped.
+	// Code example::
+	//   bt::Profiler::Reset();
+	//   ... // ticks
+	//   printf("%s", bt::Profiler::Report(bt::Profiler::SortBy::Self, 10).c_str());
+	class Profiler
+	{
+	public:
+		enum class SortBy
+		{
+			Self = 0,
+			Inclusive = 1
+		};
+
+#ifdef BT_ENABLE_PROFILING
+		static constexpr bool Enabled = true;
+#else
+		static constexpr bool Enabled = false;
+#endif
+
+		// Returns the profiles of the nodes ever ticked since last Reset(), in descending order of given time.
+		static std::vector<NodeProfile> Collect(SortBy by = SortBy::Self);
+
+		// Returns a text report table of the top limit profiles, 0 for all.
+		static std::string Report(SortBy by = SortBy::Self, std::size_t limit = 0);
+
+		// Clears all counters.
+		// Should be called when no ticking is going on.
+		static void Reset();
+
+		// Returns the number of slots of counters allocated, the slots of destroyed nodes are reused.
+		static std::size_t NumSlots();
+	};
+
+	//////////////////////////////////////////////////////////////
+	/// Trace Recorder
+	///////////////////////////////////////////////////////////////
+
+	// TraceRecord is a compact record of a node's tick.
+	struct TraceRecord
+	{
+		// Tick seq number.
+		ull seq = 0;
+		// Nanoseconds of the tick's start time since the steady clock's epoch.
+		long long startAt = 0;
+		// Nanoseconds the tick took, saturated at the max.
+		unsigned int duration = 0;
+		NodeId		 id = 0;
+		// Status returned.
+		Status status = Status::UNDEFINED;
+		// Small index of the thread ticked, starts from 0 in order of threads' first records.
+		unsigned int thread = 0;
+	};
+
+	// TraceRecorder is a flight recorder of node ticks, it keeps the latest records in a fixed-size ring buffer.
+	// Bind it to a tree (per entity or per thread, as the tree blob), then every node's Tick() writes a record
+	// on finish, without any allocation, and it can be dumped after an incident.
+	// It's safe to be written from concurrent ticking (e.g. ConcurrentParallel), but records being written may be
+	// torn if read at the same time, dump it when no ticking is going on.
+	// Code example::
+	//   bt::TraceRecorder recorder(4096);
+	//   root.BindTraceRecorder(recorder);
+	//   root.Tick(ctx);
+	//   root.UnbindTraceRecorder();
+	//   recorder.Dump(stderr);
+	class TraceRecorder
+	{
+	public:
+		// Parameter capacity is rounded up to a power of 2.
+		explicit TraceRecorder(std::size_t capacity = 4096);
+
+		// Writes a record.
+		void Record(ull seq, NodeId id, Status status, Timepoint startAt, Timepoint endAt);
+
+		// Returns the number of records kept.
+		std::size_t Size() const;
+
+		// Returns the capacity of the ring buffer.
+		std::size_t Capacity() const { return buf.size(); }
+
+		// Returns the total number of records ever written, including the overwritten ones.
+		ull NumWritten() const { return next.load(std::memory_order_relaxed); }
+
+		// Returns the records kept, from the oldest to the newest.
+		std::vector<TraceRecord> Records() const;
+
+		// Calls f on the records kept and written at or after the since-th record, from the oldest to the newest.
+		// Returns NumWritten(), to be passed as since on next call to visit only the new records.
+		ull Visit(const std::function<void(const TraceRecord&)>& f, ull since = 0) const;
+
+		// Dumps the records kept as text lines, from the oldest to the newest.
+		void Dump(std::FILE* f) const;
+
+		// Drops all records.
+		void Clear() { next.store(0, std::memory_order_relaxed); }
+
+	private:
+		std::vector<TraceRecord> buf;
+		std::size_t				 mask;
+		// Total number of records ever written.
+		std::atomic<ull> next = 0;
+	};
+
+	// ChromeTraceWriter streams trace records into a file in the chrome://tracing JSON format (also opened by
+	// Perfetto UI). Each node's tick becomes a slice named after the node, nested by time, entities are processes
+	// and threads are threads.
+	// Records are written out directly, so the memory is bounded regardless of the trace length.
+	// Code example::
+	//   bt::ChromeTraceWriter writer(fopen("trace.json", "w"));
+	//   writer.SetEntityName(1, "Entity#1");
+	//   ull since = 0;
+	//   // Periodically, e.g. per frame, before the ring buffer wraps.
+	//   since = writer.Write(root, recorder, 1, since);
+	//   ...
+	//   writer.Close();
+	class ChromeTraceWriter
+	{
+	public:
+		// The file isn't owned by the writer, but it's not closed until Close().
+		explicit ChromeTraceWriter(std::FILE* f);
+		~ChromeTraceWriter() { Close(); }
+
+		// Names the track of given entity.
+		void SetEntityName(ull entity, std::string_view name);
+
+		// Writes a record of given tree as a slice on given entity's track.
+		void Write(RootNode& root, const TraceRecord& r, ull entity);
+
+		// Writes the records of a recorder bound to given tree, starting from the since-th record.
+		// Returns the number of records ever written to the recorder, to be passed as since on the next call.
+		ull Write(RootNode& root, const TraceRecorder& recorder, ull entity, ull since = 0);
+
+		// Finishes the JSON document and flushes the file.
+		void Close();
+
+	private:
+		// Returns the names of given tree's nodes, indexed by id - 1.
+		const std::vector<std::string>& NodeNames(RootNode& root);
+
+		void WriteEventPrefix();
+
+		std::FILE* f;
+		bool	   first = true;
+		bool	   closed = false;
+		// Cached node names of trees.
+		std::unordered_map<const RootNode*, std::vector<std::string>> names;
+	};
+
+	//////////////////////////////////////////////////////////////
+	/// Visualizer
+	///////////////////////////////////////////////////////////////
+
+	// Visualizer renders a tree against its current binding tree blob to the console incrementally, it writes only
+	// the lines changed since the last frame, instead of redrawing the whole screen as RootNode::Visualize does.
+	// Lines are rendered into reusable buffers, and blobs are never allocated for rendering.
+	// Optionally, subtrees not on the active path (not ticked on given seq) are collapsed into a single line,
+	// so that huge trees stay usable.
+	// Code example::
+	//   bt::Visualizer visualizer(root);
+	//   visualizer.SetCollapseInactive(true);
+	//   // After each tick.
+	//   visualizer.Render(ctx.seq);
+	class Visualizer
+	{
+	public:
+		// The tree must be built, and its structure shouldn't change during visualizing.
+		explicit Visualizer(RootNode& root, std::FILE* out = stdout);
+
+		// Sets whether to collapse the subtrees not ticked on the rendering seq.
+		void SetCollapseInactive(bool b) { collapseInactive = b; }
+
+		// Renders a frame, and writes the changed lines to the output.
+		void Render(ull seq);
+
+		// Forces the next frame to redraw the whole screen.
+		void Reset() { dirty = true; }
+
+		// Returns the number of lines in the last frame.
+		std::size_t NumLines() const { return numLines; }
+
+		// Returns the i-th line of the last frame, without colors.
+		std::string_view Line(std::size_t i) const { return lines[i]; }
+
+		// Returns the number of lines written on the last frame.
+		std::size_t NumChangedLines() const { return numChangedLines; }
+
+	private:
+		struct Entry
+		{
+			Node* node;
+			int	  depth;
+			// Index of the entry next to this node's subtree.
+			std::size_t end;
+		};
+
+		RootNode&		   root;
+		std::FILE*		   out;
+		bool			   collapseInactive = false;
+		bool			   dirty = true;
+		std::vector<Entry> entries; // nodes in pre-order.
+		// Lines of the last frame and the frame rendering, reused across frames.
+		std::vector<std::string> lines, next;
+		// Whether the lines are colored (active).
+		std::vector<char> colors, nextColors;
+		std::size_t		  numLines = 0;
+		std::size_t		  numChangedLines = 0;
+		// Output buffer, reused across frames.
+		std::string buf;
+	};
+
+	//////////////////////////////////////////////////////////////
+	/// Tree State Dumper
+	///////////////////////////////////////////////////////////////
+
+	// TreeStateDumper dumps a machine-readable snapshot of a tree against its current binding tree blob, in JSON or
+	// Graphviz DOT, for offline analysis and diffing entities' states.
+	// Each node has its id, stable id, name, and if its blob is allocated, the lastStatus, lastSeq and running flag.
+	// Blobs are never allocated for dumping.
+	// Custom blob fields can be added by a hook, which is called for nodes with allocated blobs.
+	// Code example::
+	//   bt::TreeStateDumper dumper([](const bt::Node& node, const bt::NodeBlob& blob, auto& fields) {
+	//     if (auto p = dynamic_cast<const MyAction*>(&node))
+	//       fields.push_back({ "counter", std::to_string(static_cast<const MyAction::Blob&>(blob).counter) });
+	//   });
+	//   std::string s;
+	//   for (auto& e : entities) {
+	//     root.BindTreeBlob(e.blob);
+	//     dumper.DumpJSON(root, s);
+	//     root.UnbindTreeBlob();
+	//   }
+	class TreeStateDumper
+	{
+	public:
+		// Custom fields, pairs of name and value, values are dumped as strings.
+		using Fields = std::vector<std::pair<std::string, std::string>>;
+		// Hook to add custom fields of a node's blob.
+		using FieldsHook = std::function<void(const Node& node, const NodeBlob& blob, Fields& fields)>;
+
+		explicit TreeStateDumper(FieldsHook hook = nullptr)
+			: hook(hook) {}
+
+		// Appends a JSON object of the tree to given string, children are nested in member "children".
+		void DumpJSON(RootNode& root, std::string& out);
+
+		// Appends a Graphviz DOT digraph of the tree to given string, nodes are colored by status.
+		void DumpDOT(RootNode& root, std::string& out);
+
+	private:
+		FieldsHook hook;
+		Fields	   fields; // reused across nodes.
+	};
+
 	//////////////////////////////////////////////////////////////
 	/// Implementions (Templated functions)
 	///////////////////////////////////////////////////////////////
 
+	inline void Batch::Bind(std::size_t i)
+	{
+		root->BindTreeBlob(*blobs[i]);
+	}
+
+	template <typename T>
+	BlackboardKey<T> BlackboardLayout::Key(std::string_view name)
+	{
+		static_assert(std::is_default_constructible_v<T>, "bt: blackboard value must be default constructible");
+		void (*destroy)(void*) = nullptr;
+		if constexpr (!std::is_trivially_destructible_v<T>)
+			destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+		auto [slot, offset] = AddSlot(name, typeid(T), sizeof(T), alignof(T), [](void* p) { new (p) T(); }, destroy);
+		return { slot, offset };
+	}
+
 	template <TNodeBlob B>
 	B* ITreeBlob::Make(const NodeId id, const std::function<void(NodeBlob*)>& cb, const std::size_t cap)
 	{
+		static_assert(alignof(B) <= BlobAlign, "bt: over-aligned node blobs are not supported");
 		auto [p, b] = Make(id, sizeof(B), cap);
 		if (!b)
 			return static_cast<B*>(p);
 		auto q = new (p) B(); // call constructor
+		if constexpr (!std::is_trivially_copyable_v<B>)
+		{
+			// Relocation move-constructs into the new cell and then destroys the source, it must not throw.
+			static_assert(std::is_nothrow_move_constructible_v<B>,
+				"bt: non-trivially copyable node blobs must be nothrow move constructible");
+			static constexpr BlobOps ops = {
+				[](void* x) { static_cast<B*>(x)->~B(); },
+				[](void* dst, void* src) {
+					auto s = static_cast<B*>(src);
+					new (dst) B(std::move(*s));
+					s->~B();
+				},
+			};
+			SetOps(id - 1, &ops);
+		}
 		if (cb != nullptr)
 			cb(q);
 		return q;
@@ -1249,7 +2963,63 @@ namespace bt
 	template <std::size_t NumNodes, std::size_t MaxSizeNodeBlob>
 	FixedTreeBlob<NumNodes, MaxSizeNodeBlob>::FixedTreeBlob()
 	{
-		memset(buf, 0, sizeof(buf));
+		// Cells are zeroed on allocation, so the buffer isn't touched here.
+		for (auto& w : bits)
+			w.store(0, std::memory_order_relaxed);
+		std::fill_n(ops, NumNodes, nullptr);
+	}
+
+	template <std::size_t NumNodes, std::size_t MaxSizeNodeBlob>
+	FixedTreeBlob<NumNodes, MaxSizeNodeBlob>::FixedTreeBlob(FixedTreeBlob&& o) noexcept
+	{
+		MoveFrom(o);
+	}
+
+	template <std::size_t NumNodes, std::size_t MaxSizeNodeBlob>
+	FixedTreeBlob<NumNodes, MaxSizeNodeBlob>& FixedTreeBlob<NumNodes, MaxSizeNodeBlob>::operator=(
+		FixedTreeBlob&& o) noexcept
+	{
+		if (this != &o)
+		{
+			Destroy();
+			MoveFrom(o);
+		}
+		return *this;
+	}
+
+	template <std::size_t NumNodes, std::size_t MaxSizeNodeBlob>
+	void FixedTreeBlob<NumNodes, MaxSizeNodeBlob>::MoveFrom(FixedTreeBlob& o)
+	{
+		// Only the existing cells are relocated.
+		for (std::size_t i = 0; i < NumNodes; i++)
+			if (o.Exist(i))
+				Relocate(buf[i], o.buf[i], Stride, o.ops[i]);
+		for (std::size_t i = 0; i < NumWords; i++)
+			bits[i].store(o.bits[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		std::copy_n(o.ops, NumNodes, ops);
+		// The blobs are owned by this one now.
+		for (auto& w : o.bits)
+			w.store(0, std::memory_order_relaxed);
+		std::fill_n(o.ops, NumNodes, nullptr);
+	}
+
+	template <std::size_t NumNodes, std::size_t MaxSizeNodeBlob>
+	void FixedTreeBlob<NumNodes, MaxSizeNodeBlob>::Destroy()
+	{
+		for (std::size_t i = 0; i < NumNodes; i++)
+		{
+			if (ops[i] != nullptr && Exist(i))
+				ops[i]->destroy(Get(i));
+			ops[i] = nullptr;
+		}
+	}
+
+	template <std::size_t NumNodes, std::size_t MaxSizeNodeBlob>
+	void FixedTreeBlob<NumNodes, MaxSizeNodeBlob>::Reset()
+	{
+		Destroy();
+		for (auto& w : bits)
+			w.store(0, std::memory_order_relaxed);
 	}
 
 	template <std::size_t NumNodes, std::size_t MaxSizeNodeBlob>
@@ -1259,20 +3029,31 @@ namespace bt
 			throw std::runtime_error("bt: FixedTreeBlob NumNodes not enough");
 		if (size > MaxSizeNodeBlob)
 			throw std::runtime_error("bt: FixedTreeBlob MaxSizeNodeBlob not enough");
-		buf[idx][0] = true;
-		return Get(idx);
+		memset(buf[idx], 0, size);
+		bits[idx >> 6].fetch_or(std::uint64_t(1) << (idx & 63), std::memory_order_release);
+		return buf[idx];
 	}
 
 	template <std::size_t NumNodes, std::size_t MaxSizeNodeBlob>
 	bool FixedTreeBlob<NumNodes, MaxSizeNodeBlob>::Exist(const std::size_t idx)
 	{
-		return static_cast<bool>(buf[idx][0]);
+		return idx < NumNodes && ((bits[idx >> 6].load(std::memory_order_acquire) >> (idx & 63)) & 1);
 	}
 
 	template <std::size_t NumNodes, std::size_t MaxSizeNodeBlob>
 	void* FixedTreeBlob<NumNodes, MaxSizeNodeBlob>::Get(const std::size_t idx)
 	{
-		return &buf[idx][1];
+		return buf[idx];
+	}
+
+	template <std::size_t NumNodes, std::size_t MaxSizeNodeBlob>
+	void FixedTreeBlob<NumNodes, MaxSizeNodeBlob>::Remap(const RemapPlan& plan)
+	{
+		if (plan.src.size() > NumNodes)
+			throw std::runtime_error("bt: FixedTreeBlob NumNodes not enough");
+		// Relocates in place, the scratch cell lives on the stack.
+		alignas(BlobAlign) unsigned char scratch[Stride];
+		RemapCells(plan, buf[0], Stride, NumNodes, bits, ops, scratch);
 	}
 
 	template <TNodeBlob B>
@@ -1286,6 +3067,7 @@ namespace bt
 	void InternalBuilderBase::OnNodeAttach(T& node, RootNode* root)
 	{
 		MaintainNodeBindInfo(node, root);
+		MaintainNodeBlobInfo(node, typeid(typename T::Blob));
 		MaintainSizeInfoOnNodeAttach<T>(node, root);
 	}
 
@@ -1303,6 +3085,7 @@ namespace bt
 			// Clears the stack
 			Pop();
 		}
+		MaintainStableIds(root);
 	}
 
 	template <typename D>
@@ -1375,7 +3158,8 @@ namespace bt
 	{
 		stack.push(&r);
 		root = &r;
-		OnRootAttach(root, sizeof(D), sizeof(typename D::Blob));
+		last = &r;
+		OnRootAttach(root, sizeof(D), sizeof(typename D::Blob), typeid(typename D::Blob));
 	}
 
 	template <typename D>
@@ -0,0 +1,247 @@
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+// An async action returns the status given by the blackboard.
+class AsyncA : public bt::AsyncActionNode
+{
+public:
+	using bt::AsyncActionNode::AsyncActionNode;
+
+	Work MakeWork(const bt::Context& ctx) override
+	{
+		auto bb = std::any_cast<std::shared_ptr<Blackboard>>(ctx.data);
+		bb->counterA++;
+		auto status = bb->shouldA; // captures by value.
+		return [status](const bt::AsyncTask& task) { return status; };
+	}
+};
+
+TEMPLATE_TEST_CASE("Async/1", "[polls completion]", Entity, (EntityFixedBlob<8, sizeof(bt::AsyncActionNode::Blob)>))
+{
+	// Jobs are queued, and run manually.
+	std::vector<std::function<void()>> jobs;
+	bt::Executor					   executor = [&](std::function<void()> job) { jobs.push_back(std::move(job)); };
+
+	bt::Tree root;
+	root.Action<AsyncA>(executor).End();
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	TestType	e;
+	root.BindTreeBlob(e.blob);
+
+	bb->shouldA = bt::Status::SUCCESS;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(jobs.size() == 1);
+	REQUIRE(bb->counterA == 1);
+
+	// Not completed yet, no more submits.
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(jobs.size() == 1);
+
+	jobs[0]();
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+
+	// A new round submits a new job.
+	bb->shouldA = bt::Status::FAILURE;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(jobs.size() == 2);
+	jobs[1]();
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::FAILURE);
+	REQUIRE(bb->counterA == 2);
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("Async/2", "[inline executor]")
+{
+	bt::Executor executor = [](std::function<void()> job) { job(); };
+
+	bt::Tree root;
+	root.Action<AsyncA>(executor).End();
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+	bb->shouldA = bt::Status::SUCCESS;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("Async/3", "[work on threads]")
+{
+	std::vector<std::thread> threads;
+	bt::Executor			 executor = [&](std::function<void()> job) { threads.emplace_back(std::move(job)); };
+
+	bt::Tree root;
+	// clang-format off
+	root
+	.StatefulParallel()
+	._().Action<AsyncA>(executor)
+	._().Action<AsyncA>(executor)
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+	bb->shouldA = bt::Status::SUCCESS;
+
+	auto status = bt::Status::RUNNING;
+	while (status == bt::Status::RUNNING)
+	{
+		++ctx.seq;
+		status = root.Tick(ctx);
+		std::this_thread::yield();
+	}
+	for (auto& t : threads)
+		t.join();
+	REQUIRE(status == bt::Status::SUCCESS);
+	REQUIRE(bb->counterA == 2);
+	root.UnbindTreeBlob();
+}
+
+// An async action whose work waits until its task is cancelled, and records that it observed the cancellation.
+class AsyncWaitingCancel : public bt::AsyncActionNode
+{
+public:
+	AsyncWaitingCancel(bt::Executor executor, std::atomic<bool>* started, std::atomic<bool>* observed)
+		: bt::AsyncActionNode(std::move(executor), "AsyncWaitingCancel"), started(started), observed(observed) {}
+
+	Work MakeWork(const bt::Context& ctx) override
+	{
+		return [started = started, observed = observed](const bt::AsyncTask& task) {
+			started->store(true);
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+			while (!task.Cancelled() && std::chrono::steady_clock::now() < deadline)
+				std::this_thread::yield();
+			observed->store(task.Cancelled());
+			return bt::Status::FAILURE;
+		};
+	}
+
+private:
+	std::atomic<bool>* started;
+	std::atomic<bool>* observed;
+};
+
+TEMPLATE_TEST_CASE("Async/4", "[cancel the task of a preempted node on reset]", Entity,
+	(EntityFixedBlob<8, sizeof(bt::AsyncActionNode::Blob)>))
+{
+	std::vector<std::thread> threads;
+	bt::Executor			 executor = [&](std::function<void()> job) { threads.emplace_back(std::move(job)); };
+	std::atomic<bool>		 started = false, observed = false;
+
+	bt::Tree root;
+	// clang-format off
+	root
+	.Selector()
+	._().Condition<C>()
+	._().Action<AsyncWaitingCancel>(executor, &started, &observed)
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	TestType	e;
+	root.BindTreeBlob(e.blob);
+
+	// Tick#1: the async node is running.
+	bb->shouldC = false;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(threads.size() == 1);
+	while (!started.load())
+		std::this_thread::yield();
+
+	// Tick#2: preempted by the condition, the async node is left running.
+	bb->shouldC = true;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	root.UnbindTreeBlob();
+
+	// Respawns, the abandoned task is cancelled.
+	e.blob.Reset();
+	for (auto& t : threads)
+		t.join();
+	REQUIRE(observed.load());
+}
+
+TEST_CASE("Async/5", "[move and migrate blobs with tasks in flight]")
+{
+	static constexpr std::size_t M = std::max(sizeof(bt::AsyncActionNode::Blob), sizeof(bt::SequenceNode::Blob));
+
+	// Jobs are queued, and run manually.
+	std::vector<std::function<void()>> jobs;
+	bt::Executor					   executor = [&](std::function<void()> job) { jobs.push_back(std::move(job)); };
+
+	bt::Tree v1;
+	// clang-format off
+	v1
+	.Sequence()
+	._().Action<AsyncA>(executor)
+	.End();
+	// clang-format on
+
+	// A condition is inserted before the async action, which shifts its id.
+	bt::Tree v2;
+	// clang-format off
+	v2
+	.Sequence()
+	._().Condition<C>()
+	._().Action<AsyncA>(executor)
+	.End();
+	// clang-format on
+	bt::TreeBlobMigration migration(v1, v2);
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	bb->shouldA = bt::Status::SUCCESS;
+	bb->shouldC = true;
+
+	bt::FixedTreeBlob<4, M> a, b;
+
+	// A pending task, moved and migrated.
+	v1.BindTreeBlob(a);
+	++ctx.seq;
+	REQUIRE(v1.Tick(ctx) == bt::Status::RUNNING);
+	v1.UnbindTreeBlob();
+	b = std::move(a);
+	migration.Apply(b);
+	REQUIRE(jobs.size() == 1);
+	jobs[0]();
+	v2.BindTreeBlob(b);
+	++ctx.seq;
+	REQUIRE(v2.Tick(ctx) == bt::Status::SUCCESS);
+	v2.UnbindTreeBlob();
+
+	// A finished task, moved.
+	v1.BindTreeBlob(a);
+	++ctx.seq;
+	REQUIRE(v1.Tick(ctx) == bt::Status::RUNNING);
+	v1.UnbindTreeBlob();
+	REQUIRE(jobs.size() == 2);
+	jobs[1]();
+	bt::FixedTreeBlob<4, M> c(std::move(a));
+	v1.BindTreeBlob(c);
+	++ctx.seq;
+	REQUIRE(v1.Tick(ctx) == bt::Status::SUCCESS);
+	v1.UnbindTreeBlob();
+	REQUIRE(bb->counterA == 2);
+}
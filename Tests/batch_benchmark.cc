@@ -0,0 +1,198 @@
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+// Entities' data in columns.
+struct Columns
+{
+	std::vector<float>		 x, y;
+	std::vector<bt::Context> contexts;
+	// Index of the entity of given context.
+	std::size_t Index(const bt::Context& ctx) const { return &ctx - contexts.data(); }
+};
+
+// Checks whether an entity is close to the origin, over the position columns.
+class IsCloseColumn : public bt::ConditionNode
+{
+public:
+	explicit IsCloseColumn(const Columns* columns)
+		: bt::ConditionNode(nullptr, "IsClose"), columns(columns) {}
+
+	bool Check(const bt::Context& ctx) override
+	{
+		auto i = columns->Index(ctx);
+		return columns->x[i] * columns->x[i] + columns->y[i] * columns->y[i] < 100.0f;
+	}
+
+	void CheckBatch(std::span<const bt::Context> contexts, std::span<const std::size_t> indices,
+		bt::BatchMask& out) override
+	{
+		auto		x = columns->x.data(), y = columns->y.data();
+		std::size_t first = indices.front(), last = indices.back() + 1;
+		if (indices.size() != last - first || first % 64 != 0)
+		{
+			for (auto i : indices)
+				if (x[i] * x[i] + y[i] * y[i] < 100.0f)
+					out.Set(i);
+			return;
+		}
+		// A dense range: 64 entities a word, vectorizable.
+		auto words = out.Words();
+		for (std::size_t w = first / 64; w * 64 < last; w++)
+		{
+			std::uint64_t bits = 0;
+			std::size_t	  m = std::min<std::size_t>(64, last - w * 64);
+			auto		  xs = x + w * 64, ys = y + w * 64;
+			for (std::size_t j = 0; j < m; j++)
+				bits |= std::uint64_t(xs[j] * xs[j] + ys[j] * ys[j] < 100.0f) << j;
+			words[w] = bits;
+		}
+	}
+
+private:
+	const Columns* columns;
+};
+
+class Noop : public bt::ActionNode
+{
+public:
+	bt::Status Update(const bt::Context& ctx) override { return bt::Status::SUCCESS; }
+};
+
+TEST_CASE("Batch/Benchmark", "[batch tick vs tick one by one]")
+{
+	const int n = 50000;
+	Columns	  columns;
+	columns.x.resize(n);
+	columns.y.resize(n);
+	columns.contexts.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		// About 30% close.
+		columns.x[i] = static_cast<float>(i % 100) / 10.0f;
+		columns.y[i] = 9.5f;
+	}
+
+	bt::Tree root;
+	// clang-format off
+	root
+	.If<IsCloseColumn>(&columns)
+	._().Action<Noop>()
+	.End();
+	// clang-format on
+
+	std::vector<Entity>			entities(n);
+	std::vector<bt::ITreeBlob*> blobs(n);
+	std::vector<bt::Status>		statuses(n);
+	for (int i = 0; i < n; i++)
+		blobs[i] = &entities[i].blob;
+
+	BENCHMARK("tick one by one - 50k entities")
+	{
+		for (int i = 0; i < n; i++)
+		{
+			auto& ctx = columns.contexts[i];
+			++ctx.seq;
+			root.BindTreeBlob(entities[i].blob);
+			statuses[i] = root.Tick(ctx);
+		}
+		root.UnbindTreeBlob();
+	};
+
+	BENCHMARK("batch tick - 50k entities")
+	{
+		for (auto& ctx : columns.contexts)
+			++ctx.seq;
+		root.TickBatch(columns.contexts, blobs, statuses);
+	};
+}
+
+// Moves entities along x, over the position column, succeeds once reaching the border.
+class MoveColumn : public bt::ActionNode
+{
+public:
+	explicit MoveColumn(Columns* columns)
+		: bt::ActionNode("Move"), columns(columns) {}
+
+	bt::Status Update(const bt::Context& ctx) override
+	{
+		auto& x = columns->x[columns->Index(ctx)];
+		x += 0.1f;
+		return x > 10.0f ? bt::Status::SUCCESS : bt::Status::RUNNING;
+	}
+
+	void UpdateBatch(bt::Batch& batch, std::span<const std::size_t> indices) override
+	{
+		auto x = columns->x.data();
+		for (auto i : indices)
+		{
+			x[i] += 0.1f;
+			batch.statuses[i] = x[i] > 10.0f ? bt::Status::SUCCESS : bt::Status::RUNNING;
+		}
+	}
+
+private:
+	Columns* columns;
+};
+
+TEST_CASE("Batch/Benchmark/2", "[wavefront tick vs tick one by one]")
+{
+	const int n = 10000;
+	Columns	  columns;
+	columns.x.resize(n);
+	columns.y.resize(n);
+	columns.contexts.resize(n);
+
+	bt::Tree root;
+	// clang-format off
+	root
+	.Selector()
+	._().Sequence()
+	._()._().If<IsCloseColumn>(&columns)
+	._()._()._().Action<MoveColumn>(&columns)
+	._()._().Action<Noop>()
+	._().Parallel()
+	._()._().Action<MoveColumn>(&columns)
+	._()._().Action<Noop>()
+	.End();
+	// clang-format on
+
+	std::vector<Entity>			entities(n);
+	std::vector<bt::ITreeBlob*> blobs(n);
+	std::vector<bt::Status>		statuses(n);
+	for (int i = 0; i < n; i++)
+		blobs[i] = &entities[i].blob;
+
+	auto reset = [&] {
+		for (int i = 0; i < n; i++)
+		{
+			columns.x[i] = static_cast<float>(i % 100) / 10.0f;
+			columns.y[i] = 9.5f;
+		}
+	};
+
+	reset();
+	BENCHMARK("tick one by one - 10k entities, 10 nodes")
+	{
+		for (int i = 0; i < n; i++)
+		{
+			auto& ctx = columns.contexts[i];
+			++ctx.seq;
+			root.BindTreeBlob(entities[i].blob);
+			statuses[i] = root.Tick(ctx);
+		}
+		root.UnbindTreeBlob();
+	};
+
+	reset();
+	BENCHMARK("wavefront tick - 10k entities, 10 nodes")
+	{
+		for (auto& ctx : columns.contexts)
+			++ctx.seq;
+		root.TickBatch(columns.contexts, blobs, statuses);
+	};
+}
@@ -0,0 +1,183 @@
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+// Checks whether hp is low, counts the calls.
+class IsLowHpBatch : public bt::ConditionNode
+{
+public:
+	IsLowHpBatch(bt::BlackboardKey<int> hp, int* numChecks, int* numBatchChecks)
+		: bt::ConditionNode(nullptr, "IsLowHp"), hp(hp), numChecks(numChecks), numBatchChecks(numBatchChecks) {}
+
+	bool Check(const bt::Context& ctx) override
+	{
+		++*numChecks;
+		return ctx.blackboard->Get(hp) < 30;
+	}
+
+	void CheckBatch(std::span<const bt::Context> contexts, std::span<const std::size_t> indices,
+		bt::BatchMask& out) override
+	{
+		++*numBatchChecks;
+		for (auto i : indices)
+			if (contexts[i].blackboard->Get(hp) < 30)
+				out.Set(i);
+	}
+
+private:
+	bt::BlackboardKey<int> hp;
+	int*				   numChecks;
+	int*				   numBatchChecks;
+};
+
+// Increases hp by 10 on each tick, succeeds once hp goes to 30.
+class Heal : public bt::ActionNode
+{
+public:
+	explicit Heal(bt::BlackboardKey<int> hp)
+		: bt::ActionNode("Heal"), hp(hp) {}
+
+	bt::Status Update(const bt::Context& ctx) override
+	{
+		auto& v = ctx.blackboard->Get(hp);
+		v += 10;
+		return v >= 30 ? bt::Status::SUCCESS : bt::Status::RUNNING;
+	}
+
+private:
+	bt::BlackboardKey<int> hp;
+};
+
+TEST_CASE("Batch/1", "[guard checked for all entities at once]")
+{
+	const int			 n = 100;
+	bt::BlackboardLayout layout;
+	auto				 hp = layout.Key<int>("hp");
+
+	int numChecks = 0, numBatchChecks = 0;
+
+	// Two same trees, root1 is ticked in batch, root2 is ticked one by one.
+	bt::Tree root1, root2;
+	for (auto root : { &root1, &root2 })
+	{
+		// clang-format off
+		root->
+		If<IsLowHpBatch>(hp, &numChecks, &numBatchChecks)
+		._().Action<Heal>(hp)
+		.End();
+		// clang-format on
+	}
+
+	std::vector<bt::Blackboard>	 bbs1, bbs2;
+	std::vector<bt::Context>	 contexts1(n), contexts2(n);
+	std::vector<Entity>			 entities1(n), entities2(n);
+	std::vector<bt::ITreeBlob*>	 blobs(n);
+	std::vector<bt::Status>		 statuses(n);
+	bbs1.reserve(n);
+	bbs2.reserve(n);
+	for (int i = 0; i < n; i++)
+	{
+		bbs1.emplace_back(layout).Set(hp, i);
+		bbs2.emplace_back(layout).Set(hp, i);
+		contexts1[i].blackboard = &bbs1[i];
+		contexts2[i].blackboard = &bbs2[i];
+		blobs[i] = &entities1[i].blob;
+	}
+
+	Entity other;
+	root1.BindTreeBlob(other.blob);
+
+	for (int k = 0; k < 4; k++)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			++contexts1[i].seq;
+			++contexts2[i].seq;
+		}
+		root1.TickBatch(contexts1, blobs, statuses);
+		// The bound blob is restored.
+		REQUIRE(root1.GetTreeBlob() == &other.blob);
+
+		for (int i = 0; i < n; i++)
+		{
+			root2.BindTreeBlob(entities2[i].blob);
+			REQUIRE(root2.Tick(contexts2[i]) == statuses[i]);
+			root2.UnbindTreeBlob();
+			REQUIRE(bbs1[i].Get(hp) == bbs2[i].Get(hp));
+		}
+	}
+	REQUIRE(numBatchChecks == 4);
+	REQUIRE(numChecks == 4 * n);
+
+	// Node blobs are the same as ticking one by one.
+	for (int i = 0; i < n; i++)
+	{
+		root1.BindTreeBlob(entities1[i].blob);
+		root2.BindTreeBlob(entities2[i].blob);
+		REQUIRE(root1.LastStatus() == root2.LastStatus());
+		REQUIRE(root1.GetNodeBlob()->running == root2.GetNodeBlob()->running);
+		REQUIRE(root1.GetNodeBlob()->lastSeq == 4);
+	}
+	root1.UnbindTreeBlob();
+	root2.UnbindTreeBlob();
+
+	// Size mismatch.
+	statuses.pop_back();
+	REQUIRE_THROWS(root1.TickBatch(contexts1, blobs, statuses));
+}
+
+TEST_CASE("Batch/2", "[hooks called per entity]")
+{
+	const int n = 10;
+	bt::Tree  root;
+	// clang-format off
+	root
+	.Sequence()
+	._().If<C>()
+	._()._().Action<A>()
+	._().Action<B>()
+	.End();
+	// clang-format on
+
+	auto bb = std::make_shared<Blackboard>();
+	bb->shouldC = true;
+	bb->shouldA = bt::Status::SUCCESS;
+	bb->shouldB = bt::Status::FAILURE;
+
+	std::vector<bt::Context>	contexts(n);
+	std::vector<Entity>			entities(n);
+	std::vector<bt::ITreeBlob*> blobs(n);
+	std::vector<bt::Status>		statuses(n);
+	for (int i = 0; i < n; i++)
+	{
+		contexts[i].data = bb;
+		++contexts[i].seq;
+		blobs[i] = &entities[i].blob;
+	}
+	root.TickBatch(contexts, blobs, statuses);
+	for (auto status : statuses)
+		REQUIRE(status == bt::Status::FAILURE);
+	REQUIRE(bb->counterA == n);
+	REQUIRE(bb->counterB == n);
+	REQUIRE(bb->onEnterCalledA);
+	REQUIRE(bb->onTerminatedCalledA);
+	REQUIRE(root.GetTreeBlob() == nullptr);
+}
+
+TEST_CASE("Batch/3", "[batch mask]")
+{
+	bt::BatchMask mask;
+	mask.Reset(200);
+	REQUIRE(mask.Size() == 200);
+	REQUIRE(mask.NumWords() == 4);
+	for (std::size_t i = 0; i < 200; i++)
+		mask.Set(i);
+	mask.Clear(3, 150);
+	for (std::size_t i = 0; i < 200; i++)
+		REQUIRE(mask.Test(i) == (i < 3 || i >= 150));
+	REQUIRE(mask.Words()[1] == 0);
+	mask.Reset(10);
+	REQUIRE(!mask.Test(0));
+}
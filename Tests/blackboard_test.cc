@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+// Decreases hp by damage, succeeds once hp goes to 0.
+class Attack : public bt::ActionNode
+{
+public:
+	Attack(bt::BlackboardKey<int> hp, bt::BlackboardKey<std::string> log)
+		: bt::ActionNode("Attack"), hp(hp), log(log) {}
+
+	bt::Status Update(const bt::Context& ctx) override
+	{
+		auto& v = ctx.blackboard->Get(hp);
+		v = std::max(0, v - 10);
+		ctx.blackboard->Get(log) += "a";
+		return v == 0 ? bt::Status::SUCCESS : bt::Status::RUNNING;
+	}
+
+private:
+	bt::BlackboardKey<int>		   hp;
+	bt::BlackboardKey<std::string> log;
+};
+
+TEST_CASE("Blackboard/1", "[typed slots per entity]")
+{
+	bt::BlackboardLayout layout;
+	auto				 hp = layout.Key<int>("hp");
+	auto				 log = layout.Key<std::string>("log");
+	REQUIRE(layout.NumSlots() == 2);
+	REQUIRE(hp.slot == 0);
+	REQUIRE(log.slot == 1);
+	REQUIRE(log.offset % alignof(std::string) == 0);
+
+	// Resolving an existing key.
+	auto hp1 = layout.Key<int>("hp");
+	REQUIRE(hp1.offset == hp.offset);
+	REQUIRE_THROWS(layout.Key<double>("hp"));
+
+	bt::Tree root;
+	// clang-format off
+	root
+	.Sequence()
+	._().Action<Attack>(hp, log)
+	.End();
+	// clang-format on
+
+	struct Entity
+	{
+		bt::DynamicTreeBlob blob;
+		bt::Blackboard		bb;
+		explicit Entity(bt::BlackboardLayout& layout)
+			: bb(layout) {}
+	};
+
+	std::vector<Entity> entities;
+	entities.reserve(2);
+	entities.emplace_back(layout);
+	entities.emplace_back(layout);
+	REQUIRE(layout.Sealed());
+	REQUIRE_THROWS(layout.Key<int>("mp"));
+
+	// Default constructed.
+	REQUIRE(entities[0].bb.Get(hp) == 0);
+	REQUIRE(entities[0].bb.Get(log).empty());
+	entities[0].bb.Set(hp, 20);
+	entities[1].bb.Set(hp, 30);
+
+	bt::Context ctx;
+	bt::Status	statuses[2];
+	for (int k = 0; k < 2; k++)
+	{
+		++ctx.seq;
+		for (int i = 0; i < 2; i++)
+		{
+			auto& e = entities[i];
+			ctx.blackboard = &e.bb;
+			root.BindTreeBlob(e.blob);
+			statuses[i] = root.Tick(ctx);
+			root.UnbindTreeBlob();
+		}
+	}
+	REQUIRE(statuses[0] == bt::Status::SUCCESS);
+	REQUIRE(statuses[1] == bt::Status::RUNNING);
+	REQUIRE(entities[0].bb.Get(hp) == 0);
+	REQUIRE(entities[1].bb.Get(hp) == 10);
+	REQUIRE(entities[1].bb.Get(log) == "aa");
+
+	// Move.
+	bt::Blackboard bb(std::move(entities[1].bb));
+	REQUIRE(bb.Get(log) == "aa");
+}
@@ -0,0 +1,160 @@
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "bt.h"
+#include "types.h"
+
+// Succeeds immediately, only touches its blob.
+class Noop : public bt::ActionNode
+{
+public:
+	bt::Status Update(const bt::Context& ctx) override { return bt::Status::SUCCESS; }
+};
+
+// DTLBCounter counts dTLB load misses of this thread via Linux perf events, if available.
+class DTLBCounter
+{
+public:
+	DTLBCounter()
+	{
+#if defined(__linux__)
+		perf_event_attr attr{};
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+			| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+	~DTLBCounter()
+	{
+#if defined(__linux__)
+		if (fd >= 0)
+			close(fd);
+#endif
+	}
+
+	// Returns false if the counter is not available, e.g. not permitted.
+	bool Available() const { return fd >= 0; }
+
+	void Start()
+	{
+#if defined(__linux__)
+		if (fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	// Returns the misses since Start().
+	long long Stop()
+	{
+		long long n = 0;
+#if defined(__linux__)
+		if (fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(fd, &n, sizeof(n)) != sizeof(n))
+				n = 0;
+		}
+#endif
+		return n;
+	}
+
+private:
+	int fd = -1;
+};
+
+// Ticks all entities once, in given order.
+static void tickInOrder(bt::Tree& root, bt::Context& ctx, std::vector<std::unique_ptr<bt::SizedTreeBlob>>& blobs,
+	const std::vector<int>& order)
+{
+	++ctx.seq;
+	for (auto i : order)
+	{
+		root.BindTreeBlob(*blobs[i]);
+		root.Tick(ctx);
+	}
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("BlobArena/Benchmark", "[dTLB misses of huge pages]")
+{
+	bt::Tree root;
+	root.Parallel();
+	for (int i = 0; i < 30; i++)
+		root._().Action<Noop>();
+	root.End();
+
+	static constexpr int N = 100000;
+	auto				 n = bt::SizedTreeBlob::NumBufferBytes(root);
+
+	// Entities are ticked in random order, e.g. as they are spread in the world.
+	std::vector<int> order(N);
+	for (int i = 0; i < N; i++)
+		order[i] = i;
+	std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+	bt::Context ctx;
+	bt::BlobArena small(N * n, false);
+	bt::BlobArena huge(N * n, true);
+
+	std::vector<std::unique_ptr<bt::SizedTreeBlob>> heap, arena, hugeArena;
+	for (int i = 0; i < N; i++)
+	{
+		heap.push_back(std::make_unique<bt::SizedTreeBlob>(root));
+		arena.push_back(std::make_unique<bt::SizedTreeBlob>(root, &small));
+		hugeArena.push_back(std::make_unique<bt::SizedTreeBlob>(root, &huge));
+	}
+	// Touches all blobs first.
+	tickInOrder(root, ctx, heap, order);
+	tickInOrder(root, ctx, arena, order);
+	tickInOrder(root, ctx, hugeArena, order);
+
+	DTLBCounter counter;
+	if (!counter.Available())
+		std::printf("BlobArena/Benchmark: dTLB counters are not available, timings only.\n");
+	std::printf("BlobArena/Benchmark: %d entities, %zu MB of blobs, huge pages advised: %s\n", N,
+		N * n / 1024 / 1024, huge.HugePages() ? "yes" : "no");
+	for (auto [name, blobs] : { std::pair{ "heap", &heap }, std::pair{ "arena", &arena },
+			 std::pair{ "huge page arena", &hugeArena } })
+	{
+		counter.Start();
+		tickInOrder(root, ctx, *blobs, order);
+		auto misses = counter.Stop();
+		if (counter.Available())
+			std::printf("  %-16s dTLB load misses per entity tick: %.2f\n", name, double(misses) / N);
+	}
+
+	BENCHMARK("heap - tick 100k entities in random order, 32 nodes")
+	{
+		tickInOrder(root, ctx, heap, order);
+	};
+
+	BENCHMARK("arena - tick 100k entities in random order, 32 nodes")
+	{
+		tickInOrder(root, ctx, arena, order);
+	};
+
+	BENCHMARK("huge page arena - tick 100k entities in random order, 32 nodes")
+	{
+		tickInOrder(root, ctx, hugeArena, order);
+	};
+}
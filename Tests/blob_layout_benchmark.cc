@@ -0,0 +1,114 @@
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+using namespace std::chrono_literals;
+
+// The legacy layout of FixedTreeBlob, for comparison: the existence flag is the first byte of each cell, so the
+// stride is odd and node blobs are misaligned.
+template <std::size_t NumNodes, std::size_t MaxSizeNodeBlob>
+class LegacyFixedTreeBlob final : public bt::ITreeBlob
+{
+public:
+	LegacyFixedTreeBlob() { memset(buf, 0, sizeof(buf)); }
+	void		Reset() override { memset(buf, 0, sizeof(buf)); }
+	std::size_t NumReservedBytes() const override { return sizeof(*this); }
+	std::size_t NumAllocations() const override { return 0; }
+
+protected:
+	void* Allocate(const std::size_t idx, const std::size_t size) override
+	{
+		if (idx >= NumNodes || size > MaxSizeNodeBlob)
+			throw std::runtime_error("bt: LegacyFixedTreeBlob not enough");
+		buf[idx][0] = true;
+		return Get(idx);
+	}
+	bool  Exist(const std::size_t idx) override { return idx < NumNodes && static_cast<bool>(buf[idx][0]); }
+	void* Get(const std::size_t idx) override { return &buf[idx][1]; }
+	void  Remap(const RemapPlan& plan) override { throw std::runtime_error("bt: not supported"); }
+	void  SetOps(const std::size_t idx, const BlobOps* ops) override {}
+
+private:
+	unsigned char buf[NumNodes][MaxSizeNodeBlob + 1];
+};
+
+// Node blobs with 8-byte members.
+static constexpr std::size_t LayoutMaxSizeNodeBlob = sizeof(bt::TimeoutNode::Blob);
+
+template <typename Blob>
+static void tickAll(bt::Tree& root, bt::Context& ctx, std::vector<Blob>& blobs)
+{
+	++ctx.seq;
+	for (auto& blob : blobs)
+	{
+		root.BindTreeBlob(blob);
+		root.Tick(ctx);
+	}
+	root.UnbindTreeBlob();
+}
+
+template <typename Blob>
+static void respawnAll(bt::Tree& root, bt::Context& ctx, std::vector<Blob>& blobs)
+{
+	++ctx.seq;
+	for (auto& blob : blobs)
+	{
+		blob.Reset();
+		root.BindTreeBlob(blob);
+		root.Tick(ctx);
+	}
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("BlobLayout/Benchmark", "[aligned vs legacy fixed tree blob]")
+{
+	bt::Tree root;
+	root.Parallel();
+	for (int i = 0; i < 20; i++)
+	{
+		// clang-format off
+		root
+		._().Timeout(1000s)
+		._()._().Repeat(1000000)
+		._()._()._().Action<A>();
+		// clang-format on
+	}
+	root.End();
+	REQUIRE(root.NumNodes() == 62);
+	REQUIRE(root.MaxSizeNodeBlob() <= LayoutMaxSizeNodeBlob);
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	bb->shouldA = bt::Status::SUCCESS;
+
+	static constexpr int N = 1000;
+
+	std::vector<LegacyFixedTreeBlob<62, LayoutMaxSizeNodeBlob>> legacy(N);
+	std::vector<bt::FixedTreeBlob<62, LayoutMaxSizeNodeBlob>>	aligned(N);
+
+	BENCHMARK("legacy layout - tick 1000 entities, 62 nodes")
+	{
+		tickAll(root, ctx, legacy);
+	};
+
+	BENCHMARK("aligned layout - tick 1000 entities, 62 nodes")
+	{
+		tickAll(root, ctx, aligned);
+	};
+
+	BENCHMARK("legacy layout - respawn 1000 entities, 62 nodes")
+	{
+		respawnAll(root, ctx, legacy);
+	};
+
+	BENCHMARK("aligned layout - respawn 1000 entities, 62 nodes")
+	{
+		respawnAll(root, ctx, aligned);
+	};
+}
@@ -0,0 +1,65 @@
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+// Spawns n entities, ticks them once, and kills them, with given pooled flag.
+static void churn(bt::Tree& root, bt::Context& ctx, int n, bool pooled)
+{
+	std::vector<std::unique_ptr<bt::DynamicTreeBlob>> blobs;
+	blobs.reserve(n);
+	++ctx.seq;
+	for (int i = 0; i < n; i++)
+	{
+		auto& blob = blobs.emplace_back(std::make_unique<bt::DynamicTreeBlob>(pooled));
+		root.BindTreeBlob(*blob);
+		root.Tick(ctx);
+	}
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("BlobPool/Benchmark", "[entity churn]")
+{
+	bt::Tree root;
+	root.StatefulSequence();
+	for (int i = 0; i < 20; i++)
+	{
+		// clang-format off
+		root
+		._().Action<A>()
+		._().Action<B>();
+		// clang-format on
+	}
+	root.End();
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	bb->shouldA = bt::Status::SUCCESS;
+	bb->shouldB = bt::Status::SUCCESS;
+
+	BENCHMARK("global allocator - 1000 entities spawn and die, 42 nodes")
+	{
+		churn(root, ctx, 1000, false);
+	};
+
+	BENCHMARK("blob pool - 1000 entities spawn and die, 42 nodes")
+	{
+		churn(root, ctx, 1000, true);
+	};
+
+	std::vector<bt::DynamicTreeBlob> blobs(1000);
+	BENCHMARK("reset - 1000 entities respawn, 42 nodes")
+	{
+		++ctx.seq;
+		for (auto& blob : blobs)
+		{
+			blob.Reset();
+			root.BindTreeBlob(blob);
+			root.Tick(ctx);
+		}
+		root.UnbindTreeBlob();
+	};
+}
@@ -0,0 +1,116 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+TEST_CASE("BlobPool/1", "[reuse blocks of the same size class]")
+{
+	auto p = bt::BlobPool::Allocate(24);
+	REQUIRE(reinterpret_cast<std::uintptr_t>(p) % 16 == 0);
+	REQUIRE(bt::BlobPool::NumReservedBytes() > 0);
+	bt::BlobPool::Deallocate(p, 24);
+	// 17~32 bytes are in the same class.
+	auto q = bt::BlobPool::Allocate(32);
+	REQUIRE(q == p);
+	bt::BlobPool::Deallocate(q, 32);
+
+	// Large blocks.
+	auto r = bt::BlobPool::Allocate(bt::BlobPool::MaxSize + 1);
+	std::memset(r, 1, bt::BlobPool::MaxSize + 1);
+	bt::BlobPool::Deallocate(r, bt::BlobPool::MaxSize + 1);
+}
+
+TEST_CASE("BlobPool/2", "[concurrent allocations]")
+{
+	const int				 n = 4, m = 1000;
+	std::vector<std::thread> threads;
+	std::vector<bool>		 ok(n, true);
+	for (int t = 0; t < n; t++)
+	{
+		threads.emplace_back([t, &ok] {
+			std::vector<int*> v;
+			for (int k = 0; k < 3; k++)
+			{
+				for (int i = 0; i < m; i++)
+				{
+					auto p = static_cast<int*>(bt::BlobPool::Allocate(sizeof(int) * 8));
+					for (int j = 0; j < 8; j++)
+						p[j] = t * m + i;
+					v.push_back(p);
+				}
+				// Blocks are not shared.
+				for (int i = 0; i < m; i++)
+					for (int j = 0; j < 8; j++)
+						if (v[i][j] != t * m + i)
+							ok[t] = false;
+				for (auto p : v)
+					bt::BlobPool::Deallocate(p, sizeof(int) * 8);
+				v.clear();
+			}
+		});
+	}
+	for (auto& t : threads)
+		t.join();
+	for (int t = 0; t < n; t++)
+		REQUIRE(ok[t]);
+}
+
+TEST_CASE("BlobPool/3", "[pooled DynamicTreeBlob]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Sequence()
+	._().StatefulSequence()
+	._()._().Action<A>()
+	._()._().Action<B>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	bb->shouldA = bt::Status::SUCCESS;
+
+	// Warms up.
+	{
+		bt::DynamicTreeBlob blob(true);
+		root.BindTreeBlob(blob);
+		++ctx.seq;
+		root.Tick(ctx);
+		root.UnbindTreeBlob();
+	}
+	auto reserved = bt::BlobPool::NumReservedBytes();
+
+	// Entities spawn and die.
+	for (int i = 0; i < 100; i++)
+	{
+		bt::DynamicTreeBlob blob(true);
+		root.BindTreeBlob(blob);
+		++ctx.seq;
+		REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+		root.UnbindTreeBlob();
+	}
+	REQUIRE(bt::BlobPool::NumReservedBytes() == reserved);
+
+	// Released in bulk, then reused.
+	bt::DynamicTreeBlob blob(true);
+	root.BindTreeBlob(blob);
+	++ctx.seq;
+	root.Tick(ctx);
+	REQUIRE(blob.Peek(4)->lastStatus == bt::Status::SUCCESS);
+	blob.Release();
+	REQUIRE(blob.Peek(3) == nullptr);
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(bb->counterA == 103);
+
+	// Moves.
+	bt::DynamicTreeBlob blob1(std::move(blob));
+	REQUIRE(blob.Peek(3) == nullptr);
+	REQUIRE(blob1.Peek(3) != nullptr);
+	root.UnbindTreeBlob();
+}
@@ -1,6 +1,11 @@
 #include <catch2/catch_template_test_macros.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <string>
 
 #include "bt.h"
 #include "types.h"
@@ -128,3 +133,551 @@ TEMPLATE_TEST_CASE("Blob/2", "[multiple entites]", Entity,
 	REQUIRE(bb->counterE == 3); // +1
 	root.UnbindTreeBlob();
 }
+
+TEMPLATE_TEST_CASE("Blob/3", "[reset]", Entity, (EntityFixedBlob<16, sizeof(bt::StatefulSelectorNode::Blob)>))
+{
+	bt::Tree root;
+
+	// clang-format off
+  root
+  .StatefulSelector()
+  ._().Action<A>()
+  ._().Action<B>()
+  .End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	TestType	e;
+
+	// A fails, and is skipped during this round.
+	root.BindTreeBlob(e.blob);
+	bb->shouldA = bt::Status::FAILURE;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(bb->counterA == 1);
+	REQUIRE(bb->counterB == 2);
+	auto p = e.blob.Peek(2);
+	REQUIRE(p != nullptr);
+
+	// Respawns: A is ticked again.
+	e.blob.Reset();
+	REQUIRE(e.blob.Peek(2) == nullptr);
+	REQUIRE(e.blob.Peek(3) == nullptr);
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(bb->counterA == 2);
+	REQUIRE(bb->counterB == 3);
+	// The memory is reused.
+	REQUIRE(e.blob.Peek(2) == p);
+	REQUIRE(e.blob.Peek(2)->lastSeq == ctx.seq);
+	root.UnbindTreeBlob();
+}
+
+// A node blob owning a resource.
+struct OwningBlob : bt::NodeBlob
+{
+	std::shared_ptr<int> p;
+};
+
+// Shares x with its blob.
+class Owning : public bt::ActionNode
+{
+public:
+	using Blob = OwningBlob;
+	explicit Owning(std::shared_ptr<int> x)
+		: bt::ActionNode("Owning"), x(std::move(x)) {}
+	bt::NodeBlob* GetNodeBlob() const override { return GetNodeBlobHelper<Blob>(); }
+	bt::Status	  Update(const bt::Context& ctx) override
+	{
+		GetNodeBlobHelper<Blob>()->p = x;
+		return bt::Status::RUNNING;
+	}
+
+private:
+	std::shared_ptr<int> x;
+};
+
+TEMPLATE_TEST_CASE("Blob/4", "[destroy non-trivial node blobs]", Entity,
+	(EntityFixedBlob<16, std::max(sizeof(OwningBlob), sizeof(bt::StatefulSequenceNode::Blob))>))
+{
+	auto x = std::make_shared<int>(1);
+
+	bt::Tree v1;
+	// clang-format off
+	v1
+	.Parallel()
+	._().Action<Owning>(x)
+	._().StatefulSequence()
+	._()._().Action<A>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	{
+		TestType e;
+		v1.BindTreeBlob(e.blob);
+		++ctx.seq;
+		v1.Tick(ctx);
+		REQUIRE(x.use_count() == 3);
+
+		// Reset destroys the blobs.
+		e.blob.Reset();
+		REQUIRE(x.use_count() == 2);
+		++ctx.seq;
+		v1.Tick(ctx);
+		REQUIRE(x.use_count() == 3);
+		v1.UnbindTreeBlob();
+
+		// Moved blobs are destroyed once, by the new owner.
+		{
+			auto blob = std::move(e.blob);
+			REQUIRE(x.use_count() == 3);
+		}
+		REQUIRE(x.use_count() == 2);
+
+		// Destroyed with the entity.
+		v1.BindTreeBlob(e.blob);
+		++ctx.seq;
+		v1.Tick(ctx);
+		REQUIRE(x.use_count() == 3);
+		v1.UnbindTreeBlob();
+	}
+	REQUIRE(x.use_count() == 2);
+
+	// The blob of the removed node is dropped on migration.
+	bt::Tree v2;
+	// clang-format off
+	v2
+	.Parallel()
+	._().StatefulSequence()
+	._()._().Action<A>()
+	.End();
+	// clang-format on
+
+	TestType e;
+	v1.BindTreeBlob(e.blob);
+	++ctx.seq;
+	v1.Tick(ctx);
+	v1.UnbindTreeBlob();
+	REQUIRE(x.use_count() == 3);
+	bt::TreeBlobMigration migration(v1, v2);
+	migration.Apply(e.blob);
+	REQUIRE(x.use_count() == 2);
+}
+
+TEST_CASE("Blob/5", "[sized tree blob]")
+{
+	auto x = std::make_shared<int>(1);
+
+	bt::Tree root;
+	// clang-format off
+	root
+	.Parallel()
+	._().Action<Owning>(x)
+	._().StatefulSequence()
+	._()._().Action<A>()
+	._()._().Action<B>()
+	.End();
+	// clang-format on
+
+	bt::SizedTreeBlob blob(root);
+	REQUIRE(blob.NumNodes() == 6);
+	REQUIRE(blob.MaxSizeNodeBlob() == sizeof(bt::StatefulSequenceNode::Blob));
+	REQUIRE(blob.NumAllocations() == 1);
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	bb->shouldA = bt::Status::SUCCESS;
+	root.BindTreeBlob(blob);
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(bb->counterA == 1); // skipped by the StatefulSequence.
+	REQUIRE(bb->counterB == 2);
+	REQUIRE(x.use_count() == 3);
+	root.UnbindTreeBlob();
+
+	// No more allocations of the tree blob, the StatefulSequence's flags vector is counted besides the buffer.
+	auto report = root.ReportMemory(&blob);
+	REQUIRE(report.blobUsedBytes == report.blobFullBytes);
+	REQUIRE(blob.NumAllocations() == 1);
+	REQUIRE(report.blobAllocations == 2);
+
+	// Moves.
+	bt::SizedTreeBlob blob2(std::move(blob));
+	REQUIRE(blob2.Peek(3)->lastStatus == bt::Status::RUNNING);
+	REQUIRE(x.use_count() == 3);
+
+	// Resets.
+	blob2.Reset();
+	REQUIRE(x.use_count() == 2);
+	REQUIRE(blob2.Peek(3) == nullptr);
+	root.BindTreeBlob(blob2);
+	++ctx.seq;
+	root.Tick(ctx);
+	REQUIRE(bb->counterA == 2);
+	root.UnbindTreeBlob();
+
+	// Migrates: the Owning node is removed, and the StatefulSequence keeps its state.
+	bt::Tree v2;
+	// clang-format off
+	v2
+	.Parallel()
+	._().StatefulSequence()
+	._()._().Action<A>()
+	._()._().Action<B>()
+	.End();
+	// clang-format on
+	bt::TreeBlobMigration migration(root, v2);
+	migration.Apply(blob2);
+	REQUIRE(x.use_count() == 2);
+	v2.BindTreeBlob(blob2);
+	++ctx.seq;
+	v2.Tick(ctx);
+	REQUIRE(bb->counterA == 2);
+	REQUIRE(bb->counterB == 4);
+	v2.UnbindTreeBlob();
+
+	// Throws if not fitting.
+	bt::SizedTreeBlob small(2, sizeof(bt::NodeBlob));
+	root.BindTreeBlob(small);
+	++ctx.seq;
+	REQUIRE_THROWS(root.Tick(ctx));
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("Blob/6", "[aligned node blobs]")
+{
+	struct AlignedBlob : bt::NodeBlob
+	{
+		alignas(alignof(std::max_align_t)) unsigned char x[3];
+	};
+
+	auto aligned = [](const void* p) { return reinterpret_cast<std::uintptr_t>(p) % alignof(std::max_align_t) == 0; };
+
+	bt::FixedTreeBlob<5, sizeof(AlignedBlob)> fixed;
+	bt::SizedTreeBlob						  sized(5, sizeof(AlignedBlob));
+	bt::DynamicTreeBlob						  dynamic;
+	for (bt::ITreeBlob* blob : { static_cast<bt::ITreeBlob*>(&fixed), static_cast<bt::ITreeBlob*>(&sized),
+			 static_cast<bt::ITreeBlob*>(&dynamic) })
+	{
+		for (bt::NodeId id = 1; id <= 5; id++)
+		{
+			auto p = blob->Make<AlignedBlob>(id, nullptr);
+			REQUIRE(aligned(p));
+			REQUIRE(aligned(p->x));
+			REQUIRE(blob->Peek(id) == p);
+		}
+		// The existence flags are not stored in cells.
+		blob->Make<AlignedBlob>(3, nullptr)->x[2] = 0xff;
+		blob->Reset();
+		for (bt::NodeId id = 1; id <= 5; id++)
+			REQUIRE(blob->Peek(id) == nullptr);
+		REQUIRE(blob->Make<AlignedBlob>(3, nullptr)->x[2] == 0);
+	}
+	// No padding for cells of sizes multiple of the alignment.
+	REQUIRE(bt::FixedTreeBlob<5, 32>::Stride == 32);
+	REQUIRE(bt::FixedTreeBlob<5, 33>::Stride == 48);
+}
+
+TEST_CASE("Blob/7", "[blob arena]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.StatefulSequence()
+	._().Action<A>()
+	._().Action<B>()
+	.End();
+	// clang-format on
+
+	auto n = bt::SizedTreeBlob::NumBufferBytes(root);
+	REQUIRE(n % bt::ITreeBlob::BlobAlign == 0);
+
+	// Huge pages and locking are best efforts, depending on the system.
+	bt::BlobArena arena(3 * n, true, true);
+	REQUIRE(arena.Capacity() == 3 * n);
+
+	std::vector<bt::SizedTreeBlob> blobs;
+	blobs.reserve(3);
+	for (int i = 0; i < 2; i++)
+		blobs.emplace_back(root, &arena);
+	// A failed allocation doesn't take the space left.
+	REQUIRE_THROWS(arena.Allocate(2 * n));
+	REQUIRE(arena.NumAllocatedBytes() == 2 * n);
+	blobs.emplace_back(root, &arena);
+	REQUIRE(arena.NumAllocatedBytes() == 3 * n);
+	REQUIRE_THROWS(bt::SizedTreeBlob(root, &arena));
+	REQUIRE(blobs[0].NumAllocations() == 0);
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	bb->shouldA = bt::Status::SUCCESS;
+	++ctx.seq;
+	for (auto& blob : blobs)
+	{
+		root.BindTreeBlob(blob);
+		REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	}
+	root.UnbindTreeBlob();
+	REQUIRE(bb->counterA == 3);
+
+	// Buffers are continuous in the arena.
+	auto first = reinterpret_cast<std::uintptr_t>(blobs[0].Peek(1));
+	for (int i = 0; i < 3; i++)
+		REQUIRE(reinterpret_cast<std::uintptr_t>(blobs[i].Peek(1)) == first + i * n);
+
+	// Migrates in place.
+	bt::Tree v2;
+	// clang-format off
+	v2
+	.StatefulSequence()
+	._().Action<A>()
+	._().Action<B>()
+	.End();
+	// clang-format on
+	bt::TreeBlobMigration migration(root, v2);
+	migration.Apply(blobs[2]);
+	REQUIRE(reinterpret_cast<std::uintptr_t>(blobs[2].Peek(1)) == first + 2 * n);
+	REQUIRE(blobs[2].Peek(3)->lastStatus == bt::Status::SUCCESS);
+
+	// Moves.
+	bt::SizedTreeBlob blob(std::move(blobs[1]));
+	REQUIRE(reinterpret_cast<std::uintptr_t>(blob.Peek(1)) == first + n);
+	REQUIRE(blob.NumAllocations() == 0);
+}
+
+// A node blob whose member points into itself: std::string keeps short strings in its own buffer.
+struct StringBlob : bt::NodeBlob
+{
+	std::string s;
+};
+
+// Sets the string of its blob to given value on first tick.
+class Stringing : public bt::ActionNode
+{
+public:
+	using Blob = StringBlob;
+	explicit Stringing(std::string v)
+		: bt::ActionNode("Stringing"), v(std::move(v)) {}
+	bt::NodeBlob* GetNodeBlob() const override { return GetNodeBlobHelper<Blob>(); }
+	bt::Status	  Update(const bt::Context& ctx) override
+	{
+		auto b = GetNodeBlobHelper<Blob>();
+		if (b->s.empty())
+			b->s = v;
+		return bt::Status::RUNNING;
+	}
+
+private:
+	std::string v;
+};
+
+// Returns true if the string's buffer lies in the blob itself, i.e. it's not pointing to a relocated-from blob.
+static bool ownsBuffer(const StringBlob* b)
+{
+	auto p = reinterpret_cast<const unsigned char*>(b->s.data());
+	return p >= reinterpret_cast<const unsigned char*>(b) && p < reinterpret_cast<const unsigned char*>(b + 1);
+}
+
+TEST_CASE("Blob/8", "[relocate non-trivially copyable node blobs]")
+{
+	static constexpr std::size_t M = std::max(sizeof(StringBlob), sizeof(bt::ParallelNode::Blob));
+
+	// Moves.
+	{
+		auto a = std::make_unique<bt::FixedTreeBlob<4, M>>();
+		a->Make<StringBlob>(2, nullptr)->s = "short";
+		bt::FixedTreeBlob<4, M> b(std::move(*a));
+		a.reset();
+		auto p = b.Make<StringBlob>(2, nullptr);
+		REQUIRE(p->s == "short");
+		REQUIRE(ownsBuffer(p));
+	}
+
+	// Migrations in place.
+	bt::Tree v1;
+	// clang-format off
+	v1
+	.Parallel()
+	._().Action<Stringing>("x").Key("x")
+	._().Action<Stringing>("y").Key("y")
+	.End();
+	// clang-format on
+
+	// The two swap, a cycle of moves.
+	bt::Tree v2;
+	// clang-format off
+	v2
+	.Parallel()
+	._().Action<Stringing>("y").Key("y")
+	._().Action<Stringing>("x").Key("x")
+	.End();
+	// clang-format on
+
+	// A new node is inserted before them, y is shifted from 3 to 5, a chain of moves.
+	bt::Tree v3;
+	// clang-format off
+	v3
+	.Parallel()
+	._().Action<A>()
+	._().Action<Stringing>("x").Key("x")
+	._().Action<Stringing>("y").Key("y")
+	.End();
+	// clang-format on
+
+	bt::TreeBlobMigration m12(v1, v2), m23(v2, v3);
+	auto				  bb = std::make_shared<Blackboard>();
+	bt::Context			  ctx(bb);
+
+	auto check = [](bt::ITreeBlob* blob, bt::NodeId id, const char* s) {
+		auto p = static_cast<StringBlob*>(blob->Peek(id));
+		REQUIRE(p != nullptr);
+		REQUIRE(p->s == s);
+		REQUIRE(ownsBuffer(p));
+	};
+
+	bt::FixedTreeBlob<5, M> fixed;
+	bt::SizedTreeBlob		sized(5, M);
+	bt::DynamicTreeBlob		dynamic;
+	for (bt::ITreeBlob* blob : { static_cast<bt::ITreeBlob*>(&fixed), static_cast<bt::ITreeBlob*>(&sized),
+			 static_cast<bt::ITreeBlob*>(&dynamic) })
+	{
+		v1.BindTreeBlob(*blob);
+		++ctx.seq;
+		v1.Tick(ctx);
+		v1.UnbindTreeBlob();
+		check(blob, 3, "x");
+		check(blob, 4, "y");
+
+		m12.Apply(*blob);
+		check(blob, 3, "y");
+		check(blob, 4, "x");
+
+		m23.Apply(*blob);
+		REQUIRE(blob->Peek(3) == nullptr);
+		check(blob, 4, "x");
+		check(blob, 5, "y");
+	}
+}
+
+// Counts 3 ticks in bb->counterH and then succeeds.
+class Steps : public bt::CoroutineActionNode
+{
+public:
+	Steps()
+		: bt::CoroutineActionNode("Steps") {}
+	bt::Coroutine Run(const bt::Context& ctx) override
+	{
+		auto bb = std::any_cast<std::shared_ptr<Blackboard>>(ctx.data);
+		for (int i = 0; i < 3; i++)
+		{
+			bb->counterH++;
+			co_await bt::NextTick;
+		}
+		co_return bt::Status::SUCCESS;
+	}
+};
+
+// An async action always succeeds.
+class AsyncOk : public bt::AsyncActionNode
+{
+public:
+	using bt::AsyncActionNode::AsyncActionNode;
+	Work MakeWork(const bt::Context& ctx) override
+	{
+		return [](const bt::AsyncTask& task) { return bt::Status::SUCCESS; };
+	}
+};
+
+TEST_CASE("Blob/9", "[relocate the library's non-trivial node blobs]")
+{
+	static constexpr std::size_t M = std::max({ sizeof(bt::StatefulSequenceNode::Blob),
+		sizeof(bt::CoroutineActionNode::Blob), sizeof(bt::AsyncActionNode::Blob) });
+
+	// Jobs are queued, and run manually.
+	std::vector<std::function<void()>> jobs;
+	bt::Executor					   executor = [&](std::function<void()> job) { jobs.push_back(std::move(job)); };
+
+	bt::Tree v1;
+	// clang-format off
+	v1
+	.Parallel()
+	._().StatefulSequence()
+	._()._().Action<A>()
+	._()._().Action<B>()
+	._().Action<Steps>()
+	._().Action<AsyncOk>(executor)
+	.End();
+	// clang-format on
+
+	// A condition is inserted at the front, which shifts the ids by one.
+	bt::Tree v2;
+	// clang-format off
+	v2
+	.Parallel()
+	._().Condition<C>()
+	._().StatefulSequence()
+	._()._().Action<A>()
+	._()._().Action<B>()
+	._().Action<Steps>()
+	._().Action<AsyncOk>(executor)
+	.End();
+	// clang-format on
+	bt::TreeBlobMigration migration(v1, v2);
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+
+	// Ticks on blob a, moves a to b by given function, ticks on b, then migrates b and goes on.
+	auto check = [&](bt::ITreeBlob& a, bt::ITreeBlob& b, auto move) {
+		*bb = Blackboard{};
+		bb->shouldA = bt::Status::SUCCESS;
+		bb->shouldC = true;
+		jobs.clear();
+
+		// Tick#1: A succeeds, B, Steps and AsyncOk are running.
+		v1.BindTreeBlob(a);
+		++ctx.seq;
+		REQUIRE(v1.Tick(ctx) == bt::Status::RUNNING);
+		v1.UnbindTreeBlob();
+		REQUIRE(jobs.size() == 1);
+
+		// Tick#2: moved, A is still skipped by the stateful sequence.
+		move();
+		v1.BindTreeBlob(b);
+		++ctx.seq;
+		REQUIRE(v1.Tick(ctx) == bt::Status::RUNNING);
+		v1.UnbindTreeBlob();
+		REQUIRE(bb->counterA == 1);
+		REQUIRE(bb->counterB == 2);
+		REQUIRE(bb->counterH == 2);
+
+		// Tick#3 and Tick#4: migrated, all states are kept.
+		migration.Apply(b);
+		jobs[0]();
+		v2.BindTreeBlob(b);
+		++ctx.seq;
+		REQUIRE(v2.Tick(ctx) == bt::Status::RUNNING);
+		REQUIRE(b.Peek(8)->lastStatus == bt::Status::SUCCESS); // the async task is not cancelled.
+		++ctx.seq;
+		REQUIRE(v2.Tick(ctx) == bt::Status::RUNNING);
+		REQUIRE(b.Peek(7)->lastStatus == bt::Status::SUCCESS); // the coroutine is resumed, not restarted.
+		v2.UnbindTreeBlob();
+		REQUIRE(bb->counterA == 1);
+		REQUIRE(bb->counterB == 4);
+		REQUIRE(bb->counterH == 3);
+	};
+
+	bt::FixedTreeBlob<8, M> f1, f2;
+	check(f1, f2, [&]() { f2 = std::move(f1); });
+	bt::SizedTreeBlob s1(8, M), s2(8, M);
+	check(s1, s2, [&]() { s2 = std::move(s1); });
+	bt::DynamicTreeBlob d1(true), d2(true);
+	check(d1, d2, [&]() { d2 = std::move(d1); });
+}
@@ -0,0 +1,85 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("BudgetedTicker/1", "[round-robin with zero budget]")
+{
+	bt::BudgetedTicker		 ticker(3);
+	std::vector<std::size_t> order;
+	auto					 f = [&](std::size_t i, std::chrono::nanoseconds) { order.push_back(i); };
+
+	// Ticks one entity at least per frame.
+	for (int k = 0; k < 5; k++)
+	{
+		auto& stats = ticker.Tick(0ns, f);
+		REQUIRE(stats.ticked == 1);
+		REQUIRE(stats.deferred == 2);
+	}
+	REQUIRE(order == std::vector<std::size_t>{ 0, 1, 2, 0, 1 });
+	// Entity 2 was ticked 2 frames ago.
+	REQUIRE(ticker.LastStats().maxStarvation == 2);
+}
+
+TEST_CASE("BudgetedTicker/2", "[all ticked within budget]")
+{
+	bt::BudgetedTicker ticker(100);
+	std::vector<int>   counts(100, 0);
+	auto			   f = [&](std::size_t i, std::chrono::nanoseconds) { ++counts[i]; };
+
+	auto& stats = ticker.Tick(1h, f);
+	REQUIRE(stats.ticked == 100);
+	REQUIRE(stats.deferred == 0);
+	REQUIRE(stats.maxStarvation == 0);
+	// Each entity is ticked at most once per frame.
+	for (auto c : counts)
+		REQUIRE(c == 1);
+}
+
+TEST_CASE("BudgetedTicker/3", "[resumes deferred entities first]")
+{
+	bt::BudgetedTicker		 ticker(10);
+	std::vector<std::size_t> order;
+	auto					 f = [&](std::size_t i, std::chrono::nanoseconds) {
+		 order.push_back(i);
+		 std::this_thread::sleep_for(2ms);
+	};
+
+	auto& stats1 = ticker.Tick(3ms, f);
+	auto  ticked1 = stats1.ticked;
+	REQUIRE(ticked1 < 10);
+	REQUIRE(stats1.ticked + stats1.deferred == 10);
+
+	// The next frame starts from the first deferred one.
+	order.clear();
+	ticker.Tick(0ns, f);
+	REQUIRE(order == std::vector<std::size_t>{ ticked1 });
+}
+
+TEST_CASE("BudgetedTicker/4", "[delta and resize]")
+{
+	bt::BudgetedTicker					  ticker(2);
+	std::vector<std::chrono::nanoseconds> deltas(3, -1ns);
+	auto								  f = [&](std::size_t i, std::chrono::nanoseconds delta) { deltas[i] = delta; };
+
+	ticker.Tick(1h, f);
+	REQUIRE(deltas[0] == 0ns);
+	REQUIRE(deltas[1] == 0ns);
+
+	std::this_thread::sleep_for(5ms);
+	ticker.Resize(3);
+	ticker.Tick(1h, f);
+	REQUIRE(deltas[0] >= 5ms);
+	REQUIRE(deltas[1] >= 5ms);
+	// First tick of the new entity.
+	REQUIRE(deltas[2] == 0ns);
+
+	ticker.Resize(1);
+	REQUIRE(ticker.Size() == 1);
+	REQUIRE(ticker.Tick(1h, f).ticked == 1);
+}
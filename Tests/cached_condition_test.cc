@@ -0,0 +1,131 @@
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+// Checks whether hp is low, counts the evaluations.
+class IsLowHp : public bt::CachedConditionNode
+{
+public:
+	IsLowHp(bt::BlackboardKey<int> hp, int* counter)
+		: bt::CachedConditionNode({}, nullptr, "IsLowHp"), hp(hp), counter(counter)
+	{
+		DependsOn(hp);
+	}
+	bool Check(const bt::Context& ctx) override
+	{
+		++*counter;
+		return ctx.blackboard->Get(hp) < 30;
+	}
+
+private:
+	bt::BlackboardKey<int> hp;
+	int*				   counter;
+};
+
+TEST_CASE("CachedCondition/1", "[cache until dependencies change]")
+{
+	bt::BlackboardLayout layout;
+	auto				 hp = layout.Key<int>("hp");
+	auto				 mp = layout.Key<int>("mp");
+
+	int		 counter = 0;
+	bt::Tree root;
+	// clang-format off
+	root
+	.Selector()
+	._().Condition<IsLowHp>(hp, &counter)
+	._().Condition<bt::CachedCondition>(std::vector{ mp.slot }, [=](const bt::Context& ctx) {
+			return ctx.blackboard->Get(mp) > 0;
+		})
+	.End();
+	// clang-format on
+
+	bt::Blackboard bb(layout);
+	bb.Set(hp, 100);
+	bt::Context ctx;
+	ctx.blackboard = &bb;
+	Entity e;
+	root.BindTreeBlob(e.blob);
+
+	// First check: miss.
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::FAILURE);
+	REQUIRE(counter == 1);
+
+	// Nothing changed: hit.
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::FAILURE);
+	REQUIRE(counter == 1);
+
+	// Unrelated slot changed: still hit for IsLowHp.
+	bb.Set(mp, 10);
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	REQUIRE(counter == 1);
+
+	// Dependency changed: re-evaluated.
+	bb.Mutable(hp) = 20;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	REQUIRE(counter == 2);
+
+	// Untracked write via Get() is not noticed.
+	bb.Get(hp) = 100;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	REQUIRE(counter == 2);
+
+	// Another entity has its own cache.
+	bt::Blackboard bb2(layout);
+	bb2.Set(hp, 10);
+	Entity e2;
+	root.BindTreeBlob(e2.blob);
+	ctx.blackboard = &bb2;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	REQUIRE(counter == 3);
+
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("CachedCondition/2", "[hit and miss counters]")
+{
+	bt::BlackboardLayout layout;
+	auto				 hp = layout.Key<int>("hp");
+
+	int		 counter = 0;
+	bt::Tree root;
+	// clang-format off
+	root
+	.If<IsLowHp>(hp, &counter)
+	._().Action<A>()
+	.End();
+	// clang-format on
+
+	auto		   bb = std::make_shared<Blackboard>();
+	bt::Context	   ctx(bb);
+	bt::Blackboard board(layout);
+	ctx.blackboard = &board;
+	Entity e;
+	root.BindTreeBlob(e.blob);
+
+	IsLowHp* node = nullptr;
+	bt::TraversalCallback pre = [&](bt::Node& n, bt::Ptr<bt::Node>&) {
+		if (auto p = dynamic_cast<IsLowHp*>(&n))
+			node = p;
+	};
+	root.Traverse(pre, bt::NullTraversalCallback, bt::NullNodePtr);
+	REQUIRE(node != nullptr);
+
+	for (int i = 0; i < 10; i++)
+	{
+		++ctx.seq;
+		root.Tick(ctx);
+	}
+	REQUIRE(node->NumMisses() == 1);
+	REQUIRE(node->NumHits() == 9);
+	REQUIRE(bb->counterA == 10); // hp is 0, low.
+	root.UnbindTreeBlob();
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <string>
+
+#include "bt.h"
+#include "types.h"
+
+// Reads all content of given file.
+static std::string ReadAll(std::FILE* f)
+{
+	std::string s;
+	std::rewind(f);
+	char buf[256];
+	while (auto n = std::fread(buf, 1, sizeof(buf), f))
+		s.append(buf, n);
+	return s;
+}
+
+static int Count(const std::string& s, const std::string& x)
+{
+	int n = 0;
+	for (auto i = s.find(x); i != std::string::npos; i = s.find(x, i + 1))
+		++n;
+	return n;
+}
+
+TEST_CASE("ChromeTrace/1", "[stream records]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Sequence()
+	._().Action<A>()
+	._().Action<B>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+	bt::TraceRecorder recorder(64);
+	root.BindTraceRecorder(recorder);
+
+	auto f = std::tmpfile();
+	{
+		bt::ChromeTraceWriter writer(f);
+		writer.SetEntityName(7, "Entity \"7\"");
+
+		bb->shouldA = bt::Status::SUCCESS;
+		bt::ull since = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			++ctx.seq;
+			root.Tick(ctx);
+			// Only the new records are written.
+			since = writer.Write(root, recorder, 7, since);
+		}
+		REQUIRE(since == 12);
+		writer.Close();
+	}
+
+	auto s = ReadAll(f);
+	std::fclose(f);
+
+	REQUIRE(s.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0) == 0);
+	REQUIRE(s.substr(s.size() - 3) == "]}\n");
+	REQUIRE(Count(s, "\"ph\":\"X\"") == 12);
+	REQUIRE(Count(s, "\"name\":\"Root\"") == 3);
+	REQUIRE(Count(s, "\"name\":\"Sequence\"") == 3);
+	REQUIRE(Count(s, "\"pid\":7,") == 13);
+	REQUIRE(Count(s, "\"status\":\"RUNNING\"") == 9);
+	REQUIRE(s.find("\"args\":{\"name\":\"Entity \\\"7\\\"\"}") != std::string::npos);
+
+	root.UnbindTraceRecorder();
+	root.UnbindTreeBlob();
+}
@@ -0,0 +1,305 @@
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+// A minimal thread pool for tests.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(int n)
+	{
+		for (int i = 0; i < n; i++)
+			threads.emplace_back([this]() { Loop(); });
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard lock(mu);
+			stopped = true;
+		}
+		cv.notify_all();
+		for (auto& t : threads)
+			t.join();
+	}
+
+	void Submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard lock(mu);
+			jobs.push_back(std::move(job));
+		}
+		cv.notify_one();
+	}
+
+private:
+	std::mutex						  mu;
+	std::condition_variable			  cv;
+	std::deque<std::function<void()>> jobs;
+	std::vector<std::thread>		  threads;
+	bool							  stopped = false;
+
+	void Loop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock lock(mu);
+				cv.wait(lock, [this]() { return stopped || !jobs.empty(); });
+				if (jobs.empty())
+					return;
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+			job();
+		}
+	}
+};
+
+// Thread safe records of executions.
+struct Records
+{
+	std::mutex				  mu;
+	std::set<std::thread::id> threads;
+	int						  counter = 0;
+	bt::Status				  should[3] = { bt::Status::RUNNING, bt::Status::RUNNING, bt::Status::RUNNING };
+};
+
+// K records which thread it's ticked on, and returns the status by its index.
+class K : public bt::ActionNode
+{
+public:
+	K(Records* records, int i)
+		: bt::ActionNode("K"), records(records), i(i) {}
+
+	bt::Status Update(const bt::Context& ctx) override
+	{
+		std::lock_guard lock(records->mu);
+		records->threads.insert(std::this_thread::get_id());
+		records->counter++;
+		return records->should[i];
+	}
+
+private:
+	Records* records;
+	int		 i;
+};
+
+TEMPLATE_TEST_CASE("ConcurrentParallel/1", "[aggregation same as parallel]", Entity,
+	(EntityFixedBlob<16, sizeof(bt::NodeBlob)>))
+{
+	ThreadPool	 pool(2);
+	bt::Executor executor = [&](std::function<void()> job) { pool.Submit(std::move(job)); };
+	Records		 records;
+
+	bt::Tree root;
+	// clang-format off
+	root
+	.ConcurrentParallel(executor)
+	._().Action<K>(&records, 0)
+	._().Action<K>(&records, 1)
+	._().Sequence()
+	._()._().Action<K>(&records, 2)
+	.End();
+	// clang-format on
+
+	bt::Context ctx;
+	TestType	e;
+	root.BindTreeBlob(e.blob);
+
+	// Tick#1: all running.
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(records.counter == 3);
+
+	// Tick#2: some success.
+	records.should[0] = bt::Status::SUCCESS;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(records.counter == 6);
+
+	// Tick#3: any failure.
+	records.should[2] = bt::Status::FAILURE;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::FAILURE);
+
+	// Tick#4: all success.
+	records.should[1] = bt::Status::SUCCESS;
+	records.should[2] = bt::Status::SUCCESS;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	REQUIRE(records.counter == 12);
+
+	// Ticked on multiple threads.
+	REQUIRE(records.threads.size() > 1);
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("ConcurrentParallel/2", "[sequential fallback below threshold]")
+{
+	ThreadPool	 pool(2);
+	bt::Executor executor = [&](std::function<void()> job) { pool.Submit(std::move(job)); };
+	Records		 records;
+
+	bt::Tree root;
+	// clang-format off
+	root
+	.ConcurrentParallel(executor, 4)
+	._().Action<K>(&records, 0)
+	._().Action<K>(&records, 1)
+	._().Action<K>(&records, 2)
+	.End();
+	// clang-format on
+
+	bt::Context ctx;
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(records.counter == 3);
+	REQUIRE(records.threads.size() == 1);
+	REQUIRE(*records.threads.begin() == std::this_thread::get_id());
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("ConcurrentParallel/3", "[many entities and ticks]")
+{
+	ThreadPool	 pool(3);
+	bt::Executor executor = [&](std::function<void()> job) { pool.Submit(std::move(job)); };
+	Records		 records;
+
+	bt::Tree root;
+	// clang-format off
+	root
+	.ConcurrentParallel(executor)
+	._().StatefulSequence()
+	._()._().Action<K>(&records, 0)
+	._()._().Action<K>(&records, 1)
+	._().RandomSelector()
+	._()._().Action<K>(&records, 2)
+	._()._().Action<K>(&records, 2)
+	.End();
+	// clang-format on
+
+	records.should[0] = bt::Status::SUCCESS;
+	records.should[1] = bt::Status::SUCCESS;
+	records.should[2] = bt::Status::SUCCESS;
+
+	bt::Context			ctx;
+	std::vector<Entity> entities(50);
+	for (int i = 0; i < 10; i++)
+	{
+		for (auto& e : entities)
+		{
+			root.BindTreeBlob(e.blob);
+			++ctx.seq;
+			REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+			root.UnbindTreeBlob();
+		}
+	}
+	REQUIRE(records.counter == 50 * 10 * 3);
+}
+
+// An entity with a SizedTreeBlob for up to 32 nodes.
+struct EntitySizedBlob
+{
+	bt::SizedTreeBlob blob{ 32, sizeof(bt::NodeBlob) };
+};
+
+TEMPLATE_TEST_CASE("ConcurrentParallel/4", "[concurrent allocations of blobs sharing a bitmap word]",
+	(EntityFixedBlob<32, sizeof(bt::NodeBlob)>), EntitySizedBlob)
+{
+	ThreadPool	 pool(4);
+	bt::Executor executor = [&](std::function<void()> job) { pool.Submit(std::move(job)); };
+	Records		 records;
+	records.should[0] = bt::Status::SUCCESS;
+
+	// 16 children, their existence bits are in the same word.
+	bt::Tree root;
+	auto&	 b = root.ConcurrentParallel(executor);
+	for (int i = 0; i < 16; i++)
+		b._().template Action<K>(&records, 0);
+	b.End();
+
+	bt::Context ctx;
+	TestType	e;
+	root.BindTreeBlob(e.blob);
+	for (int i = 0; i < 200; i++)
+	{
+		// Reset, so that all children's blobs are allocated concurrently again.
+		e.blob.Reset();
+		++ctx.seq;
+		REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+		// No existence bits are lost.
+		for (bt::NodeId id = 3; id <= 18; id++)
+		{
+			auto p = e.blob.Peek(id);
+			REQUIRE(p != nullptr);
+			REQUIRE(p->lastSeq == ctx.seq);
+		}
+	}
+	REQUIRE(records.counter == 200 * 16);
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("ConcurrentParallel/5", "[executor throws]")
+{
+	ThreadPool pool(2);
+	Records	   records;
+	// Accepts 2 jobs each tick, throws on the 3rd.
+	int			 accepts = 0;
+	bt::Executor executor = [&](std::function<void()> job) {
+		if (accepts == 0)
+			throw std::runtime_error("executor is full");
+		accepts--;
+		pool.Submit([job = std::move(job)]() {
+			// Finishes after the executor throws.
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			job();
+		});
+	};
+
+	bt::Tree root;
+	// clang-format off
+	root
+	.ConcurrentParallel(executor)
+	._().Action<K>(&records, 0)
+	._().Action<K>(&records, 0)
+	._().Action<K>(&records, 0)
+	._().Action<K>(&records, 0)
+	.End();
+	// clang-format on
+
+	bt::Context ctx;
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+
+	// The 2 dispatched children are ticked before the exception leaves the tick.
+	accepts = 2;
+	++ctx.seq;
+	REQUIRE_THROWS_AS(root.Tick(ctx), std::runtime_error);
+	{
+		std::lock_guard lock(records.mu);
+		REQUIRE(records.counter == 2);
+	}
+
+	// Recovers on the next tick.
+	accepts = 3;
+	records.should[0] = bt::Status::SUCCESS;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	REQUIRE(records.counter == 6);
+	root.UnbindTreeBlob();
+}
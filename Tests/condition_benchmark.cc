@@ -0,0 +1,66 @@
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+// Number of entities and conditions of the benchmark tree.
+static const int NumEntities = 100;
+static const int NumConditions = 100;
+
+struct ConditionBlackboard
+{
+	int threshold = 0;
+};
+
+// Builds a sequence of conditions by given builder function, then an action.
+template <typename F>
+void buildConditions(bt::Tree& root, F f)
+{
+	root.Sequence();
+	for (int i = 0; i < NumConditions; i++)
+		f(root, i);
+	root._().Action<A>();
+	root.End();
+}
+
+static void tickEntities(bt::Tree& root, std::vector<Entity>& entities, bt::Context& ctx)
+{
+	++ctx.seq;
+	for (auto& e : entities)
+	{
+		root.BindTreeBlob(e.blob);
+		root.Tick(ctx);
+		root.UnbindTreeBlob();
+	}
+}
+
+TEST_CASE("Condition/Benchmark", "[lambda conditions vs std::function conditions]")
+{
+	ConditionBlackboard cbb;
+	auto				bb = std::make_shared<Blackboard>();
+	bb->shouldA = bt::Status::SUCCESS;
+	bt::Context ctx(bb);
+
+	bt::Tree root1, root2;
+	buildConditions(root1, [&](bt::Tree& root, int i) {
+		bt::ConditionNode::Checker checker = [&cbb, i](const bt::Context&) { return cbb.threshold <= i; };
+		root._().Condition(checker);
+	});
+	buildConditions(root2, [&](bt::Tree& root, int i) {
+		root._().Condition([&cbb, i](const bt::Context&) { return cbb.threshold <= i; });
+	});
+
+	std::vector<Entity> entities1(NumEntities), entities2(NumEntities);
+
+	BENCHMARK("std::function conditions - 100 entities * 100 conditions")
+	{
+		tickEntities(root1, entities1, ctx);
+	};
+
+	BENCHMARK("lambda conditions - 100 entities * 100 conditions")
+	{
+		tickEntities(root2, entities2, ctx);
+	};
+}
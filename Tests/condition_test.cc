@@ -313,3 +313,56 @@ TEST_CASE("Condition/7", "[simplest condition - not2]")
 
 	root.UnbindTreeBlob();
 }
+
+TEST_CASE("Condition/8", "[lambda conditions keep concrete types]")
+{
+	bt::Tree	root;
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+
+	auto					  isC = [](const bt::Context& ctx) {
+		 return std::any_cast<std::shared_ptr<Blackboard>>(ctx.data)->shouldC;
+	};
+	bt::ConditionNode::Checker checker = isC;
+
+	// clang-format off
+    root
+    .Switch()
+    ._().Case(isC)
+    ._()._().Action<A>()
+    ._().Case(checker)
+    ._()._().Action<B>()
+    ._().If([](const bt::Context&) { return true; })
+    ._()._().Condition(isC)
+    .End()
+    ;
+	// clang-format on
+
+	int numLambdas = 0, numConditions = 0;
+	bt::TraversalCallback pre = [&](bt::Node& node, bt::Ptr<bt::Node>&) {
+		if (dynamic_cast<bt::ConditionNode*>(&node) == nullptr)
+			return;
+		if (dynamic_cast<bt::LambdaConditionNode<decltype(isC)>*>(&node) != nullptr)
+			++numLambdas;
+		else
+			++numConditions;
+	};
+	root.Traverse(pre, bt::NullTraversalCallback, bt::NullNodePtr);
+	REQUIRE(numLambdas == 2);
+	REQUIRE(numConditions == 2); // the std::function one, and the If's lambda of another type.
+
+	Entity e;
+	root.BindTreeBlob(e.blob);
+	bb->shouldA = bt::Status::SUCCESS;
+
+	// C is false: fallback to the If.
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::FAILURE);
+	REQUIRE(bb->counterA == 0);
+
+	bb->shouldC = true;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	REQUIRE(bb->counterA == 1);
+	root.UnbindTreeBlob();
+}
@@ -0,0 +1,78 @@
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+// Number of ticks each action takes.
+static constexpr int NumSteps = 8;
+
+// Hand-written state machine, keeping its progress in a custom blob.
+class BlobStepAction : public bt::ActionNode
+{
+public:
+	struct Blob : bt::NodeBlob
+	{
+		int step = 0;
+	};
+
+	bt::NodeBlob* GetNodeBlob() const override { return GetNodeBlobHelper<Blob>(); }
+
+	void OnEnter(const bt::Context& ctx) override { GetNodeBlobHelper<Blob>()->step = 0; }
+
+	bt::Status Update(const bt::Context& ctx) override
+	{
+		auto b = GetNodeBlobHelper<Blob>();
+		if (++b->step < NumSteps)
+			return bt::Status::RUNNING;
+		return bt::Status::SUCCESS;
+	}
+};
+
+// The equivalent coroutine action.
+class CoroutineStepAction : public bt::CoroutineActionNode
+{
+public:
+	bt::Coroutine Run(const bt::Context& ctx) override
+	{
+		for (int step = 1; step < NumSteps; step++)
+			co_await bt::NextTick;
+		co_return bt::Status::SUCCESS;
+	}
+};
+
+template <typename T>
+void buildSteps(bt::Tree& root, int n)
+{
+	root.Parallel();
+	for (int i = 0; i < n; i++)
+		root._().Action<T>();
+	root.End();
+}
+
+template <typename T>
+void benchSteps(const char* name)
+{
+	bt::Tree root;
+	buildSteps<T>(root, 100);
+
+	bt::Context			ctx;
+	std::vector<Entity> entities(100);
+	BENCHMARK(name)
+	{
+		for (auto& e : entities)
+		{
+			root.BindTreeBlob(e.blob);
+			++ctx.seq;
+			root.Tick(ctx);
+			root.UnbindTreeBlob();
+		}
+	};
+}
+
+TEST_CASE("Coroutine/1", "[coroutine action vs blob action]")
+{
+	benchSteps<BlobStepAction>("bench blob-based step action - 100 entities x 100 actions");
+	benchSteps<CoroutineStepAction>("bench coroutine step action - 100 entities x 100 actions");
+}
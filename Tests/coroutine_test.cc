@@ -0,0 +1,237 @@
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "bt.h"
+#include "types.h"
+
+using namespace std::chrono_literals;
+
+// Counts 3 ticks and then succeeds.
+class CountingCoroutineAction : public bt::CoroutineActionNode
+{
+public:
+	bt::Coroutine Run(const bt::Context& ctx) override
+	{
+		auto bb = std::any_cast<std::shared_ptr<Blackboard>>(ctx.data);
+		for (int i = 0; i < 3; i++)
+		{
+			bb->counterA++;
+			const auto& ctx2 = co_await bt::NextTick;
+			bb->counterE = static_cast<int>(ctx2.seq);
+		}
+		co_return bb->shouldA;
+	}
+};
+
+// Sleeps and then waits for a signal.
+class WaitingCoroutineAction : public bt::CoroutineActionNode
+{
+public:
+	bt::Signal* signal;
+
+	explicit WaitingCoroutineAction(bt::Signal* signal)
+		: bt::CoroutineActionNode("WaitingCoroutineAction"), signal(signal) {}
+
+	bt::Coroutine Run(const bt::Context& ctx) override
+	{
+		auto bb = std::any_cast<std::shared_ptr<Blackboard>>(ctx.data);
+		co_await bt::Delay(30ms);
+		bb->counterB++;
+		co_await *signal;
+		bb->counterB++;
+		co_return bt::Status::SUCCESS;
+	}
+};
+
+TEMPLATE_TEST_CASE("Coroutine/1", "[next tick]", Entity, (EntityFixedBlob<8, sizeof(bt::CoroutineActionNode::Blob)>))
+{
+	bt::Tree root;
+	root.Action<CountingCoroutineAction>().End();
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	TestType	e;
+	root.BindTreeBlob(e.blob);
+
+	bb->shouldA = bt::Status::FAILURE;
+	for (int i = 1; i <= 3; i++)
+	{
+		++ctx.seq;
+		REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+		REQUIRE(bb->counterA == i);
+	}
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::FAILURE);
+	// The awaiting expression returns the context of current tick.
+	REQUIRE(bb->counterE == ctx.seq);
+	REQUIRE(bb->counterA == 3);
+
+	// A new round starts a new coroutine.
+	bb->shouldA = bt::Status::SUCCESS;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(bb->counterA == 4);
+	root.UnbindTreeBlob();
+}
+
+TEMPLATE_TEST_CASE("Coroutine/2", "[delay and signal]", Entity, (EntityFixedBlob<8, sizeof(bt::CoroutineActionNode::Blob)>))
+{
+	bt::Signal signal;
+	bt::Tree   root;
+	root.Action<WaitingCoroutineAction>(&signal).End();
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	TestType	e;
+	root.BindTreeBlob(e.blob);
+
+	// Delaying.
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(bb->counterB == 0);
+	std::this_thread::sleep_for(50ms);
+
+	// Waiting for the signal.
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(bb->counterB == 1);
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(bb->counterB == 1);
+
+	signal.Emit();
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	REQUIRE(bb->counterB == 2);
+	root.UnbindTreeBlob();
+}
+
+TEMPLATE_TEST_CASE("Coroutine/3", "[multiple entities]", Entity, (EntityFixedBlob<8, sizeof(bt::CoroutineActionNode::Blob)>))
+{
+	bt::Tree root;
+	root.Action<CountingCoroutineAction>().End();
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	TestType	e1, e2;
+	bb->shouldA = bt::Status::SUCCESS;
+
+	// e1 goes 2 ticks ahead of e2.
+	for (auto* e : { &e1, &e1, &e2, &e1, &e2 })
+	{
+		root.BindTreeBlob(e->blob);
+		++ctx.seq;
+		root.Tick(ctx);
+		root.UnbindTreeBlob();
+	}
+	root.BindTreeBlob(e1.blob);
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	root.BindTreeBlob(e2.blob);
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::RUNNING);
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("Coroutine/4", "[frames destroyed on another thread]")
+{
+	bt::Tree root;
+	root.Action<CountingCoroutineAction>().End();
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	Entity		e;
+
+	// Starts the coroutine on a short-lived thread, and destroys its frame on this thread after it exits.
+	auto round = [&]() {
+		std::thread t([&]() {
+			root.BindTreeBlob(e.blob);
+			++ctx.seq;
+			root.Tick(ctx);
+			root.UnbindTreeBlob();
+		});
+		t.join();
+		e.blob.Reset();
+	};
+
+	for (int i = 0; i < 20; i++)
+		round();
+	// Frames are reused across threads, no more memory is reserved.
+	auto reserved = bt::BlobPool::NumReservedBytes();
+	for (int i = 0; i < 200; i++)
+		round();
+	REQUIRE(bt::BlobPool::NumReservedBytes() == reserved);
+	REQUIRE(bb->counterA == 220);
+}
+
+TEST_CASE("Coroutine/5", "[move and migrate blobs while suspended]")
+{
+	static constexpr std::size_t M = std::max(sizeof(bt::CoroutineActionNode::Blob), sizeof(bt::SequenceNode::Blob));
+
+	bt::Tree v1;
+	// clang-format off
+	v1
+	.Sequence()
+	._().Action<CountingCoroutineAction>()
+	.End();
+	// clang-format on
+
+	// A condition is inserted before the coroutine action, which shifts its id.
+	bt::Tree v2;
+	// clang-format off
+	v2
+	.Sequence()
+	._().Condition<C>()
+	._().Action<CountingCoroutineAction>()
+	.End();
+	// clang-format on
+	bt::TreeBlobMigration migration(v1, v2);
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	bb->shouldA = bt::Status::SUCCESS;
+	bb->shouldC = true;
+
+	// Ticks on blob a, moves a to b by given function, and then goes on ticking on b.
+	auto check = [&](bt::ITreeBlob& a, bt::ITreeBlob& b, auto move) {
+		bb->counterA = 0;
+		v1.BindTreeBlob(a);
+		++ctx.seq;
+		REQUIRE(v1.Tick(ctx) == bt::Status::RUNNING);
+		v1.UnbindTreeBlob();
+		REQUIRE(bb->counterA == 1);
+
+		// Moved while suspended, the coroutine resumes.
+		move();
+		v1.BindTreeBlob(b);
+		++ctx.seq;
+		REQUIRE(v1.Tick(ctx) == bt::Status::RUNNING);
+		v1.UnbindTreeBlob();
+		REQUIRE(bb->counterA == 2);
+
+		// Migrated while suspended, the coroutine resumes.
+		migration.Apply(b);
+		v2.BindTreeBlob(b);
+		++ctx.seq;
+		REQUIRE(v2.Tick(ctx) == bt::Status::RUNNING);
+		REQUIRE(bb->counterA == 3);
+		++ctx.seq;
+		REQUIRE(v2.Tick(ctx) == bt::Status::SUCCESS);
+		v2.UnbindTreeBlob();
+	};
+
+	bt::FixedTreeBlob<4, M> f1, f2;
+	check(f1, f2, [&]() {
+		f2 = std::move(f1);
+		f1.Reset();
+	});
+	bt::SizedTreeBlob s1(4, M), s2(4, M);
+	check(s1, s2, [&]() { s2 = std::move(s1); });
+}
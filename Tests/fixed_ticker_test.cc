@@ -0,0 +1,127 @@
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <thread>
+
+#include "bt.h"
+#include "types.h"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("FixedTicker/1", "[stop inside tick function]")
+{
+	bt::FixedTicker			 ticker(1ms, bt::FixedTicker::Policy::CatchUp, bt::FixedTicker::Hybrid(500us), 1000);
+	std::chrono::nanoseconds total{ 0 };
+
+	auto startAt = std::chrono::steady_clock::now();
+	ticker.Run([&](std::chrono::nanoseconds delta) {
+		total += delta;
+		if (ticker.GetStats().ticks + 1 == 20)
+			ticker.Stop();
+	});
+	auto elapsed = std::chrono::steady_clock::now() - startAt;
+
+	auto& stats = ticker.GetStats();
+	REQUIRE(stats.ticks == 20);
+	REQUIRE(stats.skipped == 0);
+	REQUIRE(total == 20ms);
+	// Deadlines are fixed: the 20th tick starts at 19ms.
+	REQUIRE(elapsed >= 19ms);
+	REQUIRE(stats.numJitterSamples > 0);
+	REQUIRE(stats.MeanJitter() <= stats.maxJitter);
+	REQUIRE(ticker.Stopped());
+
+	// Returns immediately once stopped.
+	ticker.Run([&](std::chrono::nanoseconds) { REQUIRE(false); });
+}
+
+TEST_CASE("FixedTicker/2", "[catch up after overrun]")
+{
+	bt::FixedTicker ticker(2ms, bt::FixedTicker::Policy::CatchUp, bt::FixedTicker::Spin, 100);
+	ticker.Run([&](std::chrono::nanoseconds delta) {
+		REQUIRE(delta == 2ms);
+		auto n = ticker.GetStats().ticks + 1;
+		if (n == 2)
+			std::this_thread::sleep_for(10ms);
+		if (n == 10)
+			ticker.Stop();
+	});
+	auto& stats = ticker.GetStats();
+	REQUIRE(stats.ticks == 10);
+	REQUIRE(stats.overruns >= 1);
+	// No ticks lost.
+	REQUIRE(stats.skipped == 0);
+}
+
+TEST_CASE("FixedTicker/3", "[skip after overrun]")
+{
+	bt::FixedTicker			 ticker(2ms, bt::FixedTicker::Policy::Skip, bt::FixedTicker::Spin);
+	std::chrono::nanoseconds total{ 0 };
+	ticker.Run([&](std::chrono::nanoseconds delta) {
+		total += delta;
+		auto n = ticker.GetStats().ticks + 1;
+		if (n == 2)
+			std::this_thread::sleep_for(10ms);
+		if (n == 5)
+			ticker.Stop();
+	});
+	auto& stats = ticker.GetStats();
+	REQUIRE(stats.ticks == 5);
+	REQUIRE(stats.skipped >= 3);
+	// The deltas cover the skipped time.
+	REQUIRE(total == (stats.ticks + stats.skipped) * 2ms);
+}
+
+TEST_CASE("FixedTicker/4", "[pause and resume]")
+{
+	bt::FixedTicker	 ticker(1ms);
+	std::atomic<int> counter = 0;
+	std::thread		 t([&]() { ticker.Run([&](std::chrono::nanoseconds) { ++counter; }); });
+
+	while (counter.load() < 5)
+		std::this_thread::yield();
+
+	ticker.Pause();
+	REQUIRE(ticker.Paused());
+	std::this_thread::sleep_for(10ms); // let current tick finish.
+	auto n = counter.load();
+	std::this_thread::sleep_for(20ms);
+	REQUIRE(counter.load() == n);
+
+	ticker.Resume();
+	while (counter.load() < n + 5)
+		std::this_thread::yield();
+
+	// Stops a paused ticker.
+	ticker.Pause();
+	ticker.Stop();
+	t.join();
+	REQUIRE(ticker.Stopped());
+}
+
+TEST_CASE("FixedTicker/5", "[tick root until stopped]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Sequence()
+	._().Action<A>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+	bb->shouldA = bt::Status::SUCCESS;
+
+	bt::FixedTicker ticker(1ms, bt::FixedTicker::Policy::CatchUp, nullptr, 1000);
+	root.TickForever(ctx, ticker, false, [&](const bt::Context& ctx) {
+		if (ctx.seq == 3)
+			ticker.Stop();
+	});
+	REQUIRE(ctx.seq == 3);
+	REQUIRE(ctx.delta == 1ms);
+	REQUIRE(bb->counterA == 3);
+	root.UnbindTreeBlob();
+}
@@ -0,0 +1,104 @@
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "bt.h"
+#include "types.h"
+
+TEMPLATE_TEST_CASE("HotReload/1", "[migrate compatible node blobs to new tree]", Entity,
+	(EntityFixedBlob<16, sizeof(bt::RepeatNode::Blob)>))
+{
+	bt::Tree v1;
+	// clang-format off
+	v1
+	.Sequence()
+	._().Repeat(3)
+	._()._().Action<A>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	TestType	e;
+
+	// Tick#1 and Tick#2, the repeat node counts to 2.
+	bb->shouldA = bt::Status::SUCCESS;
+	v1.BindTreeBlob(e.blob);
+	++ctx.seq;
+	REQUIRE(v1.Tick(ctx) == bt::Status::RUNNING);
+	++ctx.seq;
+	REQUIRE(v1.Tick(ctx) == bt::Status::RUNNING);
+	REQUIRE(bb->counterA == 2);
+	v1.UnbindTreeBlob();
+
+	// A new condition is inserted before the repeat node, which shifts the ids.
+	bt::Tree v2;
+	// clang-format off
+	v2
+	.Sequence()
+	._().Condition<C>()
+	._().Repeat(3)
+	._()._().Action<A>()
+	.End();
+	// clang-format on
+
+	bt::TreeBlobMigration migration(v1, v2);
+	// Root, Repeat and A are kept, the Sequence's children changed.
+	REQUIRE(migration.NumKept() == 3);
+	migration.Apply(e.blob);
+
+	// Tick#3: the repeat node continues counting.
+	bb->shouldC = true;
+	v2.BindTreeBlob(e.blob);
+	++ctx.seq;
+	REQUIRE(v2.Tick(ctx) == bt::Status::SUCCESS);
+	REQUIRE(bb->counterA == 3);
+	v2.UnbindTreeBlob();
+}
+
+TEMPLATE_TEST_CASE("HotReload/2", "[drop blobs of changed nodes]", Entity,
+	(EntityFixedBlob<16, sizeof(bt::RepeatNode::Blob)>))
+{
+	bt::Tree v1;
+	// clang-format off
+	v1
+	.Repeat(3)
+	._().Action<A>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	TestType	e;
+
+	bb->shouldA = bt::Status::SUCCESS;
+	v1.BindTreeBlob(e.blob);
+	++ctx.seq;
+	REQUIRE(v1.Tick(ctx) == bt::Status::RUNNING);
+	++ctx.seq;
+	REQUIRE(v1.Tick(ctx) == bt::Status::RUNNING);
+	v1.UnbindTreeBlob();
+
+	// The repeat node is replaced by a loop node with another name.
+	bt::Tree v2;
+	// clang-format off
+	v2
+	.Loop(3)
+	._().Action<A>()
+	.End();
+	// clang-format on
+
+	bt::TreeBlobMigration migration(v1, v2);
+	REQUIRE(migration.NumKept() == 0); // the root's child changed, and A is under another path.
+	migration.Apply(e.blob);
+
+	// The loop node starts counting from the beginning.
+	v2.BindTreeBlob(e.blob);
+	++ctx.seq;
+	REQUIRE(v2.Tick(ctx) == bt::Status::RUNNING);
+	++ctx.seq;
+	REQUIRE(v2.Tick(ctx) == bt::Status::RUNNING);
+	++ctx.seq;
+	REQUIRE(v2.Tick(ctx) == bt::Status::SUCCESS);
+	REQUIRE(bb->counterA == 5);
+	v2.UnbindTreeBlob();
+}
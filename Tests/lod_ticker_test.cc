@@ -0,0 +1,80 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("LodTicker/1", "[staggered periods]")
+{
+	bt::LodTicker ticker(18);
+	// 2 entities every frame, 16 entities every 16 frames.
+	for (std::size_t i = 2; i < 18; i++)
+		ticker.SetPeriod(i, 16);
+	REQUIRE(ticker.Period(0) == 1);
+	REQUIRE(ticker.Period(2) == 16);
+
+	std::vector<int> counts(18, 0);
+	auto			 f = [&](std::size_t i, std::chrono::nanoseconds) { ++counts[i]; };
+
+	for (int k = 0; k < 32; k++)
+	{
+		// Evenly staggered: 2 + 1 entities per frame.
+		REQUIRE(ticker.Tick(16ms, f) == 3);
+	}
+	REQUIRE(counts[0] == 32);
+	REQUIRE(counts[1] == 32);
+	for (std::size_t i = 2; i < 18; i++)
+		REQUIRE(counts[i] == 2);
+}
+
+TEST_CASE("LodTicker/2", "[accumulated delta]")
+{
+	bt::LodTicker ticker(2);
+	ticker.SetPeriod(1, 4);
+
+	std::vector<std::chrono::nanoseconds> deltas(2, -1ns);
+	auto f = [&](std::size_t i, std::chrono::nanoseconds delta) { deltas[i] = delta; };
+
+	// Finds the first frame entity 1 is ticked.
+	while (deltas[1] < 0ns)
+		ticker.Tick(10ms, f);
+	REQUIRE(deltas[1] == 0ns);
+
+	deltas[1] = -1ns;
+	int frames = 0;
+	while (deltas[1] < 0ns)
+	{
+		ticker.Tick(10ms, f);
+		++frames;
+	}
+	REQUIRE(frames == 4);
+	REQUIRE(deltas[1] == 40ms);
+	REQUIRE(deltas[0] == 10ms);
+}
+
+TEST_CASE("LodTicker/3", "[change period and resize]")
+{
+	bt::LodTicker ticker(4);
+	ticker.SetPeriod(0, 2);
+	ticker.SetPeriod(1, 2);
+	ticker.SetPeriod(0, 1);
+	ticker.SetPeriod(1, 1);
+
+	std::vector<int> counts(4, 0);
+	auto			 f = [&](std::size_t i, std::chrono::nanoseconds) { ++counts[i]; };
+
+	REQUIRE(ticker.Tick(1ms, f) == 4);
+
+	ticker.Resize(2);
+	REQUIRE(ticker.Size() == 2);
+	REQUIRE(ticker.Tick(1ms, f) == 2);
+
+	ticker.Resize(3);
+	REQUIRE(ticker.Tick(1ms, f) == 3);
+	REQUIRE(counts == std::vector<int>{ 3, 3, 2, 1 });
+
+	REQUIRE_THROWS(ticker.SetPeriod(0, 0));
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "bt.h"
+#include "types.h"
+
+TEST_CASE("MemoryReport/1", "[tree memory]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Sequence()
+	._().Action<A>()
+	._().StatefulSelector()
+	._()._().Action<B>()
+	.End();
+	// clang-format on
+
+	auto report = root.ReportMemory();
+	REQUIRE(report.numNodes == 5);
+	REQUIRE(report.nodeBytes == root.TreeSize());
+	// At least the children vectors of the composite nodes.
+	REQUIRE(report.nodeHeapBytes >= 3 * sizeof(bt::Ptr<bt::Node>));
+	REQUIRE(report.blobFullBytes == 4 * sizeof(bt::NodeBlob) + sizeof(bt::StatefulSelectorNode::Blob));
+	// No tree blob given.
+	REQUIRE(report.blobUsedBytes == 0);
+	REQUIRE(report.blobReservedBytes == 0);
+	REQUIRE(report.blobAllocations == 0);
+
+	// Long names are on the heap.
+	bt::Tree root2;
+	// clang-format off
+	root2
+	.Sequence()
+	._().Action<A>()
+	._().StatefulSelector()
+	._()._().Action<B>()
+	.End();
+	// clang-format on
+	bt::Tree root3("A very long name of the root node");
+	// clang-format off
+	root3
+	.Sequence()
+	._().Action<A>()
+	._().StatefulSelector()
+	._()._().Action<B>()
+	.End();
+	// clang-format on
+	REQUIRE(root2.ReportMemory().nodeHeapBytes == report.nodeHeapBytes);
+	REQUIRE(root3.ReportMemory().nodeHeapBytes > report.nodeHeapBytes + 33);
+}
+
+TEST_CASE("MemoryReport/2", "[tree blob memory]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Selector()
+	._().Action<A>()
+	._().StatefulSequence()
+	._()._().Action<B>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	bb->shouldA = bt::Status::RUNNING;
+
+	SECTION("fixed")
+	{
+		EntityFixedBlob<8, sizeof(bt::StatefulSequenceNode::Blob)> e;
+		auto report = root.ReportMemory(&e.blob);
+		REQUIRE(report.blobUsedBytes == 0);
+		REQUIRE(report.blobReservedBytes == sizeof(e.blob));
+		REQUIRE(report.blobPaddingBytes == sizeof(e.blob));
+		REQUIRE(report.blobAllocations == 0);
+
+		// Root, Selector and A are ticked, the Selector makes the StatefulSequence's blob to query its priority.
+		root.BindTreeBlob(e.blob);
+		++ctx.seq;
+		root.Tick(ctx);
+		root.UnbindTreeBlob();
+		report = root.ReportMemory(&e.blob);
+		auto used = 3 * sizeof(bt::NodeBlob) + sizeof(bt::StatefulSequenceNode::Blob);
+		REQUIRE(report.blobUsedBytes == used);
+		REQUIRE(report.blobPaddingBytes == sizeof(e.blob) - used);
+		// The StatefulSequence's flags vector.
+		REQUIRE(report.blobHeapBytes > 0);
+		REQUIRE(report.blobAllocations == 1);
+	}
+
+	SECTION("dynamic")
+	{
+		bool				pooled = GENERATE(false, true);
+		bt::DynamicTreeBlob blob(pooled);
+		auto				report = root.ReportMemory(&blob);
+		REQUIRE(report.blobUsedBytes == 0);
+		REQUIRE(report.blobReservedBytes == sizeof(blob));
+		REQUIRE(report.blobAllocations == 0);
+
+		root.BindTreeBlob(blob);
+		++ctx.seq;
+		root.Tick(ctx);
+		root.UnbindTreeBlob();
+		report = root.ReportMemory(&blob);
+		REQUIRE(report.blobUsedBytes == 3 * sizeof(bt::NodeBlob) + sizeof(bt::StatefulSequenceNode::Blob));
+		REQUIRE(report.blobReservedBytes >= sizeof(blob) + 5 * sizeof(void*) + report.blobUsedBytes);
+		REQUIRE(report.blobPaddingBytes == report.blobReservedBytes - report.blobUsedBytes);
+		// The slots vector, the StatefulSequence's flags vector, and the blocks if not pooled.
+		REQUIRE(report.blobHeapBytes > 0);
+		REQUIRE(report.blobAllocations == (pooled ? 2 : 6));
+
+		// The slots vector is kept for rebinding.
+		blob.Release();
+		report = root.ReportMemory(&blob);
+		REQUIRE(report.blobUsedBytes == 0);
+		REQUIRE(report.blobHeapBytes == 0);
+		REQUIRE(report.blobAllocations == 1);
+	}
+}
@@ -0,0 +1,149 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+using namespace std::chrono_literals;
+
+class SlowAction : public bt::ActionNode
+{
+public:
+	SlowAction()
+		: bt::ActionNode("ProfilingSlow") {}
+	bt::Status Update(const bt::Context& ctx) override
+	{
+		std::this_thread::sleep_for(1ms);
+		return bt::Status::SUCCESS;
+	}
+};
+
+TEST_CASE("Profiling/1", "[profile nodes]")
+{
+	REQUIRE(bt::Profiler::Enabled);
+
+	bt::Tree root;
+	// clang-format off
+	root
+	.Sequence()
+	._().Action<SlowAction>()
+	._().Action<SlowAction>()
+	.End();
+	// clang-format on
+
+	bt::Context ctx;
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+
+	bt::Profiler::Reset();
+	for (int i = 0; i < 3; i++)
+	{
+		++ctx.seq;
+		root.Tick(ctx);
+	}
+
+	// Sorted by self time, the slow actions come first.
+	auto profiles = bt::Profiler::Collect(bt::Profiler::SortBy::Self);
+	REQUIRE(profiles.size() == 4);
+	for (int i = 0; i < 2; i++)
+	{
+		auto& p = profiles[i];
+		REQUIRE(p.name == "ProfilingSlow");
+		REQUIRE(p.calls == 3);
+		REQUIRE(p.statuses[static_cast<int>(bt::Status::SUCCESS)] == 3);
+		REQUIRE(p.self >= 3ms);
+		REQUIRE(p.self == p.inclusive);
+		REQUIRE(p.Percentile(0.5) >= 1ms);
+		REQUIRE(root.FindNodeId(p.stableId) == p.id);
+	}
+
+	// Sorted by inclusive time, the root comes first.
+	profiles = bt::Profiler::Collect(bt::Profiler::SortBy::Inclusive);
+	REQUIRE(profiles[0].name == "Root");
+	REQUIRE(profiles[0].id == 1);
+	REQUIRE(profiles[0].inclusive >= 6ms);
+	REQUIRE(profiles[0].self < profiles[0].inclusive);
+	REQUIRE(profiles[1].name == "Sequence");
+	REQUIRE(profiles[1].inclusive >= profiles[2].inclusive + profiles[3].inclusive);
+
+	auto report = bt::Profiler::Report(bt::Profiler::SortBy::Self, 2);
+	REQUIRE(report.find("ProfilingSlow") != std::string::npos);
+	REQUIRE(report.find("Sequence") == std::string::npos);
+
+	bt::Profiler::Reset();
+	REQUIRE(bt::Profiler::Collect().empty());
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("Profiling/2", "[merge threads]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Sequence()
+	._().Action<SlowAction>()
+	.End();
+	// clang-format on
+
+	bt::Profiler::Reset();
+	std::vector<std::thread> threads;
+	for (int k = 0; k < 4; k++)
+	{
+		threads.emplace_back([&root]() {
+			bt::Context ctx;
+			Entity		e;
+			// A tree binds one blob at a time, so the threads take turns.
+			static std::mutex mu;
+			std::lock_guard	  lock(mu);
+			root.BindTreeBlob(e.blob);
+			++ctx.seq;
+			root.Tick(ctx);
+			root.UnbindTreeBlob();
+		});
+	}
+	for (auto& t : threads)
+		t.join();
+
+	auto profiles = bt::Profiler::Collect();
+	REQUIRE(profiles.size() == 3);
+	for (auto& p : profiles)
+		REQUIRE(p.calls == 4);
+}
+
+TEST_CASE("Profiling/3", "[reuse slots of destroyed nodes]")
+{
+	auto build = []() {
+		auto root = std::make_unique<bt::Tree>();
+		// clang-format off
+		(*root)
+		.Sequence()
+		._().Action<A>()
+		.End();
+		// clang-format on
+		return root;
+	};
+
+	bt::Profiler::Reset();
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	std::size_t n = 0;
+	for (int i = 0; i < 100; i++)
+	{
+		// Rebuilds, like hot reloads.
+		auto   root = build();
+		Entity e;
+		root->BindTreeBlob(e.blob);
+		++ctx.seq;
+		root->Tick(ctx);
+		root->UnbindTreeBlob();
+		if (i == 0)
+			n = bt::Profiler::NumSlots();
+		// Only the living tree is reported.
+		REQUIRE(bt::Profiler::Collect().size() == 3);
+	}
+	REQUIRE(bt::Profiler::NumSlots() == n);
+	REQUIRE(bt::Profiler::Collect().empty());
+}
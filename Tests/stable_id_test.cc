@@ -0,0 +1,147 @@
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+
+#include "bt.h"
+#include "types.h"
+
+// Returns the stable id of the first node with given name.
+static bt::StableNodeId FindStableId(bt::Tree& root, std::string_view name)
+{
+	bt::StableNodeId	  ans = 0;
+	bt::TraversalCallback pre = [&](bt::Node& node, bt::Ptr<bt::Node>& ptr) {
+		if (!ans && node.Name() == name)
+			ans = node.StableId();
+	};
+	root.Traverse(pre, bt::NullTraversalCallback, bt::NullNodePtr);
+	return ans;
+}
+
+TEST_CASE("StableId/1", "[stable ids are independent of build order]")
+{
+	bt::Tree v1, v2;
+	// clang-format off
+	v1
+	.Sequence()
+	._().Action<J>("a", "")
+	._().Action<J>("b", "")
+	.End();
+
+	v2
+	.Sequence()
+	._().Action<J>("c", "")
+	._().Action<J>("a", "")
+	._().Action<J>("b", "")
+	.End();
+	// clang-format on
+
+	REQUIRE(FindStableId(v1, "a") != 0);
+	REQUIRE(FindStableId(v1, "a") != FindStableId(v1, "b"));
+	REQUIRE(FindStableId(v1, "a") == FindStableId(v2, "a"));
+	REQUIRE(FindStableId(v1, "b") == FindStableId(v2, "b"));
+	REQUIRE(v1.StableId() == v2.StableId());
+
+	// Remap tables.
+	auto stableIdB = FindStableId(v2, "b");
+	auto idB = v2.FindNodeId(stableIdB);
+	REQUIRE(idB == 5);
+	REQUIRE(v1.FindNodeId(stableIdB) == 4);
+	REQUIRE(v2.StableIdOf(idB) == stableIdB);
+	REQUIRE(v2.FindNodeId(FindStableId(v2, "c")) == 3);
+	REQUIRE(v1.FindNodeId(FindStableId(v2, "c")) == 0);
+}
+
+TEST_CASE("StableId/2", "[siblings with the same name]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Parallel()
+	._().Action<A>()
+	._().Action<A>()
+	._().Action<B>()
+	.End();
+	// clang-format on
+
+	std::vector<bt::StableNodeId> ids;
+	bt::TraversalCallback		  pre = [&](bt::Node& node, bt::Ptr<bt::Node>& ptr) {
+		   ids.push_back(node.StableId());
+	};
+	root.Traverse(pre, bt::NullTraversalCallback, bt::NullNodePtr);
+	REQUIRE(ids.size() == 5);
+	std::sort(ids.begin(), ids.end());
+	REQUIRE(std::unique(ids.begin(), ids.end()) == ids.end());
+}
+
+TEST_CASE("StableId/3", "[explicit keys]")
+{
+	bt::Tree v1, v2;
+	// clang-format off
+	v1
+	.Sequence()
+	._().Action<J>("a", "").Key("attack")
+	.End();
+
+	v2
+	.Selector()
+	._().Parallel()
+	._()._().Action<J>("b", "").Key("attack")
+	.End();
+	// clang-format on
+
+	// The keyed node keeps its stable id in another place.
+	REQUIRE(FindStableId(v1, "a") == FindStableId(v2, "b"));
+
+	// Keys should be unique.
+	bt::Tree v3;
+	// clang-format off
+	v3
+	.Sequence()
+	._().Action<A>().Key("x")
+	._().Action<B>().Key("x");
+	// clang-format on
+	REQUIRE_THROWS_AS(v3.End(), std::runtime_error);
+}
+
+TEMPLATE_TEST_CASE("StableId/4", "[migrate keyed nodes]", Entity,
+	(EntityFixedBlob<16, sizeof(bt::RepeatNode::Blob)>))
+{
+	bt::Tree v1;
+	// clang-format off
+	v1
+	.Sequence()
+	._().Repeat(3).Key("r")
+	._()._().Action<A>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	TestType	e;
+
+	bb->shouldA = bt::Status::SUCCESS;
+	v1.BindTreeBlob(e.blob);
+	++ctx.seq;
+	REQUIRE(v1.Tick(ctx) == bt::Status::RUNNING);
+	v1.UnbindTreeBlob();
+
+	// The keyed repeat node is moved under a new decorator.
+	bt::Tree v2;
+	// clang-format off
+	v2
+	.Sequence()
+	._().ForceSuccess()
+	._()._().Repeat(2).Key("r")
+	._()._()._().Action<A>()
+	.End();
+	// clang-format on
+
+	bt::TreeBlobMigration migration(v1, v2);
+	migration.Apply(e.blob);
+
+	v2.BindTreeBlob(e.blob);
+	++ctx.seq;
+	REQUIRE(v2.Tick(ctx) == bt::Status::SUCCESS); // the counter continues: 2 == 2
+	REQUIRE(bb->counterA == 2);
+	v2.UnbindTreeBlob();
+}
@@ -0,0 +1,139 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+
+#include "bt.h"
+#include "types.h"
+
+TEST_CASE("TraceRecorder/1", "[record ticks]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Sequence()
+	._().Action<A>()
+	._().Action<B>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+
+	bt::TraceRecorder recorder(100);
+	REQUIRE(recorder.Capacity() == 128);
+	root.BindTraceRecorder(recorder);
+	REQUIRE(root.GetTraceRecorder() == &recorder);
+
+	bb->shouldA = bt::Status::SUCCESS;
+	bb->shouldB = bt::Status::RUNNING;
+	++ctx.seq;
+	root.Tick(ctx);
+
+	// Records are written on ticks' finish: children first.
+	auto records = recorder.Records();
+	REQUIRE(records.size() == 4);
+	REQUIRE(records[0].id == 3);
+	REQUIRE(records[0].status == bt::Status::SUCCESS);
+	REQUIRE(records[1].id == 4);
+	REQUIRE(records[1].status == bt::Status::RUNNING);
+	REQUIRE(records[2].id == 2);
+	REQUIRE(records[3].id == 1);
+	REQUIRE(records[3].status == bt::Status::RUNNING);
+	for (auto& r : records)
+		REQUIRE(r.seq == 1);
+	// The root starts first, and ends last.
+	REQUIRE(records[3].startAt <= records[0].startAt);
+	REQUIRE(records[3].startAt + records[3].duration >= records[1].startAt + records[1].duration);
+
+	// No more records once unbound.
+	root.UnbindTraceRecorder();
+	++ctx.seq;
+	root.Tick(ctx);
+	REQUIRE(recorder.Size() == 4);
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("TraceRecorder/2", "[ring buffer]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Sequence()
+	._().Action<A>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+	bt::TraceRecorder recorder(8);
+	root.BindTraceRecorder(recorder);
+
+	for (int i = 0; i < 10; i++)
+	{
+		++ctx.seq;
+		root.Tick(ctx);
+	}
+	REQUIRE(recorder.NumWritten() == 30);
+	REQUIRE(recorder.Size() == 8);
+
+	// Keeps the latest ones.
+	auto records = recorder.Records();
+	REQUIRE(records.front().seq == 8);
+	REQUIRE(records.back().seq == 10);
+	REQUIRE(records.back().id == 1);
+
+	auto f = std::tmpfile();
+	recorder.Dump(f);
+	REQUIRE(std::ftell(f) > 0);
+	std::fclose(f);
+
+	recorder.Clear();
+	REQUIRE(recorder.Size() == 0);
+	REQUIRE(recorder.Records().empty());
+	root.UnbindTraceRecorder();
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("TraceRecorder/3", "[bound before build]")
+{
+	bt::TraceRecorder recorder(16);
+
+	bt::Tree subtree("Sub");
+	// clang-format off
+	subtree
+	.Sequence()
+	._().Action<B>()
+	.End();
+	// clang-format on
+
+	// Nodes built or attached after binding record too.
+	bt::Tree root;
+	root.BindTraceRecorder(recorder);
+	// clang-format off
+	root
+	.Sequence()
+	._().Action<A>()
+	._().Subtree(std::move(subtree))
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+	bb->shouldA = bt::Status::SUCCESS;
+	bb->shouldB = bt::Status::SUCCESS;
+	++ctx.seq;
+	REQUIRE(root.Tick(ctx) == bt::Status::SUCCESS);
+	// Root, Sequence, A, Sub, Sequence and B.
+	REQUIRE(recorder.Size() == 6);
+
+	root.UnbindTraceRecorder();
+	++ctx.seq;
+	root.Tick(ctx);
+	REQUIRE(recorder.Size() == 6);
+	root.UnbindTreeBlob();
+}
@@ -0,0 +1,97 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+#include "bt.h"
+#include "types.h"
+
+struct CounterBlob : bt::NodeBlob
+{
+	int counter = 0;
+};
+
+class CounterAction : public bt::ActionNode
+{
+public:
+	using Blob = CounterBlob;
+	CounterAction()
+		: bt::ActionNode("Counter \"x\"") {}
+	bt::NodeBlob* GetNodeBlob() const override { return GetNodeBlobHelper<Blob>(); }
+	bt::Status	  Update(const bt::Context& ctx) override
+	{
+		++GetNodeBlobHelper<Blob>()->counter;
+		return bt::Status::RUNNING;
+	}
+};
+
+TEST_CASE("TreeStateDumper/1", "[json]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Sequence()
+	._().Action<CounterAction>()
+	.End();
+	// clang-format on
+
+	bt::TreeStateDumper dumper([](const bt::Node& node, const bt::NodeBlob& blob, auto& fields) {
+		if (dynamic_cast<const CounterAction*>(&node) != nullptr)
+			fields.push_back({ "counter", std::to_string(static_cast<const CounterBlob&>(blob).counter) });
+	});
+
+	bt::Context ctx;
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+
+	// Dumps without ticking: no blobs allocated.
+	std::string s;
+	dumper.DumpJSON(root, s);
+	auto stableId = [&](bt::NodeId id) { return "\"stableId\":\"" + std::to_string(root.StableIdOf(id)) + "\""; };
+	REQUIRE(s
+		== "{\"id\":1," + stableId(1) + ",\"name\":\"Root\",\"children\":[" + "{\"id\":2," + stableId(2)
+			+ ",\"name\":\"Sequence\",\"children\":[" + "{\"id\":3," + stableId(3)
+			+ ",\"name\":\"Counter \\\"x\\\"\",\"children\":[]}]}]}");
+	REQUIRE(root.GetTreeBlob()->Peek(3) == nullptr);
+
+	++ctx.seq;
+	root.Tick(ctx);
+	s.clear();
+	dumper.DumpJSON(root, s);
+	REQUIRE(s.find("\"name\":\"Root\",\"lastStatus\":\"RUNNING\",\"lastSeq\":1,\"running\":true,\"children\"")
+		!= std::string::npos);
+	REQUIRE(s.find("\"running\":true,\"fields\":{\"counter\":\"1\"},\"children\":[]}") != std::string::npos);
+
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("TreeStateDumper/2", "[dot]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Selector()
+	._().Action<A>()
+	._().Action<CounterAction>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+	bb->shouldA = bt::Status::FAILURE;
+	++ctx.seq;
+	root.Tick(ctx);
+
+	bt::TreeStateDumper dumper;
+	std::string			s;
+	dumper.DumpDOT(root, s);
+	REQUIRE(s.rfind("digraph bt {\n", 0) == 0);
+	REQUIRE(s.find("  n1 [label=\"Root\\n#1 RUNNING\\nseq=1 running\", fillcolor=gold];\n") != std::string::npos);
+	REQUIRE(s.find("  n3 [label=\"Action\\n#3 FAILURE\\nseq=1\", fillcolor=salmon];\n") != std::string::npos);
+	REQUIRE(s.find("  n4 [label=\"Counter \\\"x\\\"\\n#4 RUNNING") != std::string::npos);
+	REQUIRE(s.find("  n1 -> n2;\n") != std::string::npos);
+	REQUIRE(s.find("  n2 -> n3;\n") != std::string::npos);
+	REQUIRE(s.find("  n2 -> n4;\n") != std::string::npos);
+	REQUIRE(s.substr(s.size() - 2) == "}\n");
+	root.UnbindTreeBlob();
+}
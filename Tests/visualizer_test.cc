@@ -0,0 +1,114 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+
+#include "bt.h"
+#include "types.h"
+
+TEST_CASE("Visualizer/1", "[incremental rendering]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Sequence()
+	._().Action<A>()
+	._().Action<B>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+
+	auto			f = std::tmpfile();
+	bt::Visualizer	visualizer(root, f);
+
+	// Renders without ticking: no blobs allocated.
+	visualizer.Render(ctx.seq);
+	REQUIRE(visualizer.NumLines() == 4);
+	REQUIRE(visualizer.NumChangedLines() == 4);
+	REQUIRE(visualizer.Line(0) == "Root(U)");
+	REQUIRE(visualizer.Line(1) == " |- Sequence(U)");
+	REQUIRE(visualizer.Line(2) == " |---|- Action(U)");
+	REQUIRE(visualizer.Line(3) == " |---|- Action(U)");
+	REQUIRE(root.GetTreeBlob()->Peek(1) == nullptr);
+	REQUIRE(root.GetTreeBlob()->Peek(3) == nullptr);
+
+	// A goes SUCCESS, B keeps RUNNING.
+	bb->shouldA = bt::Status::SUCCESS;
+	++ctx.seq;
+	root.Tick(ctx);
+	visualizer.Render(ctx.seq);
+	REQUIRE(visualizer.NumChangedLines() == 4);
+	REQUIRE(visualizer.Line(2) == " |---|- Action(S)");
+	REQUIRE(visualizer.Line(3) == " |---|- Action(R)");
+
+	// Nothing changed except the seq, all lines still active.
+	++ctx.seq;
+	root.Tick(ctx);
+	visualizer.Render(ctx.seq);
+	REQUIRE(visualizer.NumChangedLines() == 0);
+
+	// Only B changed.
+	bb->shouldB = bt::Status::FAILURE;
+	++ctx.seq;
+	root.Tick(ctx);
+	visualizer.Render(ctx.seq);
+	REQUIRE(visualizer.NumChangedLines() == 3);
+	REQUIRE(visualizer.Line(0) == "Root(F)");
+	REQUIRE(visualizer.Line(2) == " |---|- Action(S)");
+
+	// Renders an old seq: the lines become inactive (uncolored).
+	visualizer.Render(ctx.seq - 1);
+	REQUIRE(visualizer.NumChangedLines() == 4);
+
+	visualizer.Reset();
+	visualizer.Render(ctx.seq);
+	REQUIRE(visualizer.NumChangedLines() == 4);
+
+	std::fclose(f);
+	root.UnbindTreeBlob();
+}
+
+TEST_CASE("Visualizer/2", "[collapse inactive subtrees]")
+{
+	bt::Tree root;
+	// clang-format off
+	root
+	.Selector()
+	._().If<C>()
+	._()._().Sequence()
+	._()._()._().Action<A>()
+	._()._()._().Action<B>()
+	._().Action<E>()
+	.End();
+	// clang-format on
+
+	auto		bb = std::make_shared<Blackboard>();
+	bt::Context ctx(bb);
+	Entity		e;
+	root.BindTreeBlob(e.blob);
+
+	auto		   f = std::tmpfile();
+	bt::Visualizer visualizer(root, f);
+	visualizer.SetCollapseInactive(true);
+
+	// C is false, the If's subtree isn't ticked.
+	bb->shouldC = false;
+	++ctx.seq;
+	root.Tick(ctx);
+	visualizer.Render(ctx.seq);
+	REQUIRE(visualizer.NumLines() == 6);
+	REQUIRE(visualizer.Line(2) == " |---|- If<Condition>(F)");
+	REQUIRE(visualizer.Line(3) == " |---|---|- Condition(F)");
+	REQUIRE(visualizer.Line(4) == " |---|---|- Sequence(U) [+2]");
+	REQUIRE(visualizer.Line(5) == " |---|- Action(R)");
+
+	// Nothing ticked on this seq, collapsed at the root.
+	visualizer.Render(ctx.seq + 1);
+	REQUIRE(visualizer.NumLines() == 1);
+	REQUIRE(visualizer.Line(0) == "Root(R) [+7]");
+
+	std::fclose(f);
+	root.UnbindTreeBlob();
+}
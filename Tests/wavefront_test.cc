@@ -0,0 +1,196 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+#include "bt.h"
+#include "types.h"
+
+// Returns a pseudo random status by the entity's seed, tick seq and its salt, logs the call.
+class Scripted : public bt::ActionNode
+{
+public:
+	Scripted(char salt, bt::BlackboardKey<int> seed, bt::BlackboardKey<std::string> log)
+		: bt::ActionNode("Scripted"), salt(salt), seed(seed), log(log) {}
+
+	bt::Status Update(const bt::Context& ctx) override
+	{
+		ctx.blackboard->Get(log).push_back(salt);
+		auto v = (ctx.blackboard->Get(seed) * 31 + ctx.seq * 7 + salt * 13) % 3;
+		return v == 0 ? bt::Status::RUNNING : (v == 1 ? bt::Status::SUCCESS : bt::Status::FAILURE);
+	}
+
+private:
+	char						   salt;
+	bt::BlackboardKey<int>		   seed;
+	bt::BlackboardKey<std::string> log;
+};
+
+// Counts the UpdateBatch calls.
+class BatchCounter : public bt::ActionNode
+{
+public:
+	explicit BatchCounter(int* counter)
+		: bt::ActionNode("BatchCounter"), counter(counter) {}
+
+	bt::Status Update(const bt::Context& ctx) override { return bt::Status::SUCCESS; }
+
+	void UpdateBatch(bt::Batch& batch, std::span<const std::size_t> indices) override
+	{
+		++*counter;
+		for (auto i : indices)
+			batch.statuses[i] = bt::Status::SUCCESS;
+	}
+
+private:
+	int* counter;
+};
+
+// Builds a tree mixing all kinds of composites.
+static void build(bt::Tree& root, bt::BlackboardKey<int> seed, bt::BlackboardKey<std::string> log)
+{
+	// clang-format off
+	root
+	.Parallel()
+	._().Sequence()
+	._()._().Action<Scripted>('a', seed, log)
+	._()._().Selector()
+	._()._()._().Action<Scripted>('b', seed, log)
+	._()._()._().Invert()
+	._()._()._()._().Action<Scripted>('c', seed, log)
+	._()._().Action<Scripted>('d', seed, log)
+	._().StatefulSequence()
+	._()._().Action<Scripted>('e', seed, log)
+	._()._().If([=](const bt::Context& ctx) { return ctx.blackboard->Get(seed) % 2 == 0; })
+	._()._()._().Action<Scripted>('f', seed, log)
+	._()._().Action<Scripted>('g', seed, log)
+	._().StatefulSelector()
+	._()._().Action<Scripted>('h', seed, log)
+	._()._().StatefulParallel()
+	._()._()._().Action<Scripted>('i', seed, log)
+	._()._()._().Action<Scripted>('j', seed, log)
+	._()._().RandomSelector()
+	._()._()._().Action<Scripted>('k', seed, log)
+	.End();
+	// clang-format on
+}
+
+TEST_CASE("Wavefront/1", "[same results as ticking one by one]")
+{
+	const int			 n = 64;
+	bt::BlackboardLayout layout;
+	auto				 seed = layout.Key<int>("seed");
+	auto				 log = layout.Key<std::string>("log");
+
+	bt::Tree root1, root2;
+	build(root1, seed, log);
+	build(root2, seed, log);
+
+	std::vector<bt::Blackboard> bbs1, bbs2;
+	std::vector<bt::Context>	contexts1(n), contexts2(n);
+	std::vector<Entity>			entities1(n), entities2(n);
+	std::vector<bt::ITreeBlob*> blobs(n);
+	std::vector<bt::Status>		statuses(n);
+	bbs1.reserve(n);
+	bbs2.reserve(n);
+	for (int i = 0; i < n; i++)
+	{
+		bbs1.emplace_back(layout).Set(seed, i * 7 + 3);
+		bbs2.emplace_back(layout).Set(seed, i * 7 + 3);
+		contexts1[i].blackboard = &bbs1[i];
+		contexts2[i].blackboard = &bbs2[i];
+		blobs[i] = &entities1[i].blob;
+	}
+
+	for (int k = 0; k < 20; k++)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			++contexts1[i].seq;
+			++contexts2[i].seq;
+		}
+		// Small chunks on odd ticks.
+		root1.TickBatch(contexts1, blobs, statuses, k % 2 ? 7 : 256);
+		for (int i = 0; i < n; i++)
+		{
+			root2.BindTreeBlob(entities2[i].blob);
+			REQUIRE(root2.Tick(contexts2[i]) == statuses[i]);
+			root2.UnbindTreeBlob();
+			// The same calls in the same order.
+			REQUIRE(bbs1[i].Get(log) == bbs2[i].Get(log));
+		}
+	}
+}
+
+TEST_CASE("Wavefront/2", "[leaves receive batches]")
+{
+	const int n = 10;
+	int		  counter = 0;
+	bt::Tree  root;
+	// clang-format off
+	root
+	.Sequence()
+	._().Selector()
+	._()._().Condition<C>()
+	._()._().Action<BatchCounter>(&counter)
+	._().Parallel()
+	._()._().Action<BatchCounter>(&counter)
+	._()._().Action<BatchCounter>(&counter)
+	.End();
+	// clang-format on
+
+	auto bb = std::make_shared<Blackboard>();
+
+	std::vector<bt::Context>	contexts(n);
+	std::vector<Entity>			entities(n);
+	std::vector<bt::ITreeBlob*> blobs(n);
+	std::vector<bt::Status>		statuses(n);
+	for (int i = 0; i < n; i++)
+	{
+		contexts[i].data = bb;
+		blobs[i] = &entities[i].blob;
+	}
+	for (auto& ctx : contexts)
+		++ctx.seq;
+	root.TickBatch(contexts, blobs, statuses);
+	for (auto status : statuses)
+		REQUIRE(status == bt::Status::SUCCESS);
+	// Once per leaf.
+	REQUIRE(counter == 3);
+}
+
+TEST_CASE("Wavefront/3", "[fallback for unequal priorities]")
+{
+	const int n = 10;
+	bt::Tree  root;
+	// clang-format off
+	root
+	.Selector()
+	._().Action<G>()
+	._().Action<H>()
+	.End();
+	// clang-format on
+
+	auto bb = std::make_shared<Blackboard>();
+	bb->shouldPriorityG = 1;
+	bb->shouldPriorityH = 2;
+	bb->shouldG = bt::Status::SUCCESS;
+	bb->shouldH = bt::Status::FAILURE;
+
+	std::vector<bt::Context>	contexts(n);
+	std::vector<Entity>			entities(n);
+	std::vector<bt::ITreeBlob*> blobs(n);
+	std::vector<bt::Status>		statuses(n);
+	for (int i = 0; i < n; i++)
+	{
+		contexts[i].data = bb;
+		blobs[i] = &entities[i].blob;
+	}
+	for (auto& ctx : contexts)
+		++ctx.seq;
+	root.TickBatch(contexts, blobs, statuses);
+	// H goes first.
+	for (auto status : statuses)
+		REQUIRE(status == bt::Status::SUCCESS);
+	REQUIRE(bb->counterH == n);
+	REQUIRE(bb->counterG == n);
+}